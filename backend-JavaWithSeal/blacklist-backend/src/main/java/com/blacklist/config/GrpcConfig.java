@@ -4,10 +4,18 @@ import lombok.Data;
 import org.springframework.boot.context.properties.ConfigurationProperties;
 import org.springframework.context.annotation.Configuration;
 
+import java.util.List;
+
 @Data
 @Configuration
 @ConfigurationProperties(prefix = "grpc.server")
 public class GrpcConfig {
     private String address;
     private Integer port;
+
+    /**
+     * psisrv分片节点列表（host:port），配置后srv_data按哈希前缀划分到各节点，
+     * 查询并发发往全部节点；为空时只连接address:port
+     */
+    private List<String> shards;
 }
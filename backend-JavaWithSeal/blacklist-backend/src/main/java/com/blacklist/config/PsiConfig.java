@@ -0,0 +1,40 @@
+package com.blacklist.config;
+
+import lombok.Data;
+import org.springframework.boot.context.properties.ConfigurationProperties;
+import org.springframework.context.annotation.Configuration;
+
+@Data
+@Configuration
+@ConfigurationProperties(prefix = "blacklist.psi")
+public class PsiConfig {
+    /**
+     * srv_data快照目录，为空时不落盘
+     */
+    private String snapshotDir;
+
+    /**
+     * srv_data转换（哈希+编码）并行线程数，0表示使用全部CPU核数
+     */
+    private int convertThreads;
+
+    /**
+     * 客户端上下文缓存容量（按摘要复用，客户端可只发送摘要）
+     */
+    private int contextCacheSize = 16;
+
+    /**
+     * psisrv匹配内存预算（MB），并发请求的估算占用超出时排队，0表示不限制
+     */
+    private long memoryBudgetMb;
+
+    /**
+     * payload不超过该字节数的查询走优先队列
+     */
+    private long priorityPayloadBytes = 4 * 1024 * 1024;
+
+    /**
+     * 排队超时时间（秒）
+     */
+    private int queueTimeoutSeconds = 180;
+}
@@ -2,6 +2,10 @@ package com.blacklist.controller;
 
 import com.blacklist.common.Result;
 import com.blacklist.dto.BlacklistCreateDTO;
+import com.blacklist.dto.BlacklistEntryParam;
+import com.blacklist.dto.BlacklistIngestDTO;
+import com.blacklist.dto.BlacklistIngestParam;
+import com.blacklist.dto.BlacklistRemoveParam;
 import com.blacklist.dto.BlacklistStatusDTO;
 import com.blacklist.service.BlacklistService;
 import lombok.extern.slf4j.Slf4j;
@@ -11,6 +15,7 @@ import org.springframework.web.bind.annotation.*;
 
 import javax.validation.constraints.Max;
 import javax.validation.constraints.Min;
+import java.util.List;
 import java.util.Map;
 
 /**
@@ -60,4 +65,33 @@ public class BlacklistController {
             return Result.error(e.getMessage());
         }
     }
+
+    /**
+     * 新增或更新黑名单条目（增量，不重建整个黑名单）
+     */
+    @PostMapping("/entries")
+    public Result<Void> upsertEntries(@RequestBody List<BlacklistEntryParam> entries) {
+        log.info("收到黑名单增量更新请求，条数: {}", entries != null ? entries.size() : 0);
+        blacklistService.upsertEntries(entries);
+        return Result.success();
+    }
+
+    /**
+     * 删除黑名单条目（增量，不重建整个黑名单）
+     */
+    @PostMapping("/entries/remove")
+    public Result<Integer> removeEntries(@RequestBody BlacklistRemoveParam param) {
+        log.info("收到黑名单增量删除请求，条数: {}",
+                param.getIdCards() != null ? param.getIdCards().size() : 0);
+        return Result.success(blacklistService.removeEntries(param.getIdCards()));
+    }
+
+    /**
+     * 从导出文件批量导入黑名单并构建srv_data（文件位于后端所在机器）
+     */
+    @PostMapping("/ingest")
+    public Result<BlacklistIngestDTO> ingestDump(@RequestBody BlacklistIngestParam param) {
+        log.info("收到批量导入请求: {}, {}", param.getMainFile(), param.getRecordFile());
+        return Result.success(blacklistService.ingestDump(param));
+    }
 }
@@ -0,0 +1,21 @@
+package com.blacklist.controller;
+
+import com.blacklist.grpc.PsiMetrics;
+import org.springframework.beans.factory.annotation.Autowired;
+import org.springframework.web.bind.annotation.GetMapping;
+import org.springframework.web.bind.annotation.RestController;
+
+/**
+ * 指标Controller（Prometheus文本格式，直接返回纯文本，不包装为Result）
+ */
+@RestController
+public class MetricsController {
+
+    @Autowired
+    private PsiMetrics psiMetrics;
+
+    @GetMapping(value = "/metrics", produces = "text/plain; version=0.0.4; charset=utf-8")
+    public String metrics() {
+        return psiMetrics.scrape();
+    }
+}
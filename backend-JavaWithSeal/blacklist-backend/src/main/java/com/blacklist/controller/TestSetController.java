@@ -1,10 +1,13 @@
 package com.blacklist.controller;
 
+import com.blacklist.common.BusinessException;
 import com.blacklist.common.Result;
 import com.blacklist.dto.EncryptedDataParam;
 import com.blacklist.dto.QueryRequestParam;
 import com.blacklist.dto.QueryResultDTO;
+import com.blacklist.dto.SchedulerStatsDTO;
 import com.blacklist.dto.TestSetCreateParam;
+import com.blacklist.grpc.MatchScheduler;
 import com.blacklist.service.TestSetService;
 import lombok.extern.slf4j.Slf4j;
 import org.springframework.beans.factory.annotation.Autowired;
@@ -28,6 +31,9 @@ public class TestSetController {
     @Autowired
     private TestSetService testSetService;
 
+    @Autowired
+    private MatchScheduler matchScheduler;
+
     /**
      * 创建测试集
      */
@@ -60,24 +66,39 @@ public class TestSetController {
         if (params.getPayloadData() == null || params.getPayloadData().isEmpty()) {
             return Result.error(400, "加密负载数据不能为空");
         }
-        if (params.getContextData() == null || params.getContextData().isEmpty()) {
+        boolean hasContext = params.getContextData() != null && !params.getContextData().isEmpty();
+        boolean hasDigest = params.getContextDigest() != null && !params.getContextDigest().isEmpty();
+        if (!hasContext && !hasDigest) {
             return Result.error(400, "上下文数据不能为空");
         }
 
-        log.info("Payload长度: {}, Context长度: {}",
+        log.info("Payload长度: {}, Context长度: {}, Context摘要: {}",
                 params.getPayloadData().length(),
-                params.getContextData().length());
+                hasContext ? params.getContextData().length() : 0,
+                params.getContextDigest());
 
         try {
             QueryResultDTO result = testSetService.queryBlacklist(
                     params.getPayloadData(),
-                    params.getContextData()
+                    params.getContextData(),
+                    params.getContextDigest()
             );
             return Result.success(result);
+        } catch (BusinessException e) {
+            log.warn("查询失败: {}", e.getMessage());
+            return Result.error(e.getCode(), e.getMessage());
         } catch (Exception e) {
             log.error("查询失败", e);
             return Result.error(500, "查询失败: " + e.getMessage());
         }
     }
 
+    /**
+     * 匹配调度状态（排队数、等待时间、内存占用）
+     */
+    @GetMapping("/scheduler")
+    public Result<SchedulerStatsDTO> getSchedulerStats() {
+        return Result.success(matchScheduler.getStats());
+    }
+
 }
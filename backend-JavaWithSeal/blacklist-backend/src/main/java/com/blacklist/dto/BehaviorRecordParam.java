@@ -0,0 +1,9 @@
+package com.blacklist.dto;
+
+import lombok.Data;
+
+@Data
+public class BehaviorRecordParam {
+    private Integer behaviorType;  // 行为类型code（1-藏匿, 2-投诉, 3-其他）
+    private Integer tool;          // 使用工具code（1-刀具, 2-打火机, 3-其他）
+}
@@ -0,0 +1,15 @@
+package com.blacklist.dto;
+
+import lombok.Data;
+
+import java.util.List;
+
+/**
+ * 单条黑名单新增/更新参数
+ */
+@Data
+public class BlacklistEntryParam {
+    private String idCard;                      // 身份证号
+    private Integer riskLevel;                  // 行为评级code（1-A, 2-B, 3-C）
+    private List<BehaviorRecordParam> records;  // 行为记录（1-3条）
+}
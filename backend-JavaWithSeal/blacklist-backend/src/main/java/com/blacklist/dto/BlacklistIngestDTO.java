@@ -0,0 +1,30 @@
+package com.blacklist.dto;
+
+import lombok.Data;
+
+/**
+ * 黑名单批量导入结果DTO
+ */
+@Data
+public class BlacklistIngestDTO {
+
+    /**
+     * 导入后的黑名单版本号（COUNT-MAX(user_id)）
+     */
+    private String version;
+
+    /**
+     * srv_data条数
+     */
+    private Integer srvDataCount;
+
+    /**
+     * 行为记录条数
+     */
+    private Long recordCount;
+
+    /**
+     * 耗时（毫秒）
+     */
+    private Long elapsedMillis;
+}
@@ -0,0 +1,10 @@
+package com.blacklist.dto;
+
+import lombok.Data;
+
+@Data
+public class BlacklistIngestParam {
+    private String mainFile;    // blacklist_main导出文件路径（后端所在机器）
+    private String recordFile;  // behavior_record导出文件路径（后端所在机器）
+    private String delimiter;   // 列分隔符，为空时按扩展名判断（.tsv为制表符，其余为逗号）
+}
@@ -0,0 +1,10 @@
+package com.blacklist.dto;
+
+import lombok.Data;
+
+import java.util.List;
+
+@Data
+public class BlacklistRemoveParam {
+    private List<String> idCards;  // 待删除的身份证号列表
+}
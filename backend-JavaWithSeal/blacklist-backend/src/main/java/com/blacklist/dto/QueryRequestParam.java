@@ -5,5 +5,6 @@ import lombok.Data;
 @Data
 public class QueryRequestParam {
     private String payloadData;  // Base64编码的加密负载
-    private String contextData;  // Base64编码的上下文
+    private String contextData;  // Base64编码的上下文（后端已缓存时可为空）
+    private String contextDigest; // 上下文SHA256摘要（十六进制）
 }
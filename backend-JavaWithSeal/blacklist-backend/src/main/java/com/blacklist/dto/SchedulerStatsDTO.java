@@ -0,0 +1,55 @@
+package com.blacklist.dto;
+
+import lombok.Data;
+
+/**
+ * PSI匹配调度状态DTO
+ */
+@Data
+public class SchedulerStatsDTO {
+
+    /**
+     * 内存预算（字节），0表示不限制
+     */
+    private Long budgetBytes;
+
+    /**
+     * 已放行请求的估算内存占用（字节）
+     */
+    private Long inUseBytes;
+
+    /**
+     * 正在执行的匹配数
+     */
+    private Integer running;
+
+    /**
+     * 优先队列（小查询）排队数
+     */
+    private Integer priorityQueueDepth;
+
+    /**
+     * 批量队列排队数
+     */
+    private Integer bulkQueueDepth;
+
+    /**
+     * 累计放行数
+     */
+    private Long admittedTotal;
+
+    /**
+     * 累计排队超时数
+     */
+    private Long rejectedTotal;
+
+    /**
+     * 累计排队等待时间（毫秒）
+     */
+    private Long totalWaitMillis;
+
+    /**
+     * 最长排队等待时间（毫秒）
+     */
+    private Long maxWaitMillis;
+}
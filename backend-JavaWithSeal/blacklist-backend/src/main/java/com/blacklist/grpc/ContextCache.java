@@ -0,0 +1,70 @@
+package com.blacklist.grpc;
+
+import com.blacklist.config.PsiConfig;
+import com.google.protobuf.ByteString;
+import lombok.extern.slf4j.Slf4j;
+import org.springframework.beans.factory.annotation.Autowired;
+import org.springframework.stereotype.Component;
+
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.LinkedHashMap;
+import java.util.Map;
+
+/**
+ * 客户端上下文缓存（LRU，按SHA256摘要索引）
+ *
+ * 上下文包含公钥和重线性化密钥，体积可达数MB，且同一客户端的多次查询完全相同。
+ * 后端缓存解码后的上下文，客户端再次查询时只需发送摘要，省去上传和Base64解码。
+ */
+@Slf4j
+@Component
+public class ContextCache {
+
+    @Autowired
+    private PsiConfig psiConfig;
+
+    private final LinkedHashMap<String, ByteString> cache = new LinkedHashMap<>(16, 0.75f, true);
+
+    /**
+     * 保存上下文并返回其摘要
+     */
+    public synchronized String put(ByteString context) {
+        String digest = digest(context);
+        cache.put(digest, context);
+
+        int capacity = Math.max(psiConfig.getContextCacheSize(), 1);
+        while (cache.size() > capacity) {
+            Map.Entry<String, ByteString> eldest = cache.entrySet().iterator().next();
+            cache.remove(eldest.getKey());
+            log.info("上下文缓存已满，淘汰: {}", eldest.getKey());
+        }
+        return digest;
+    }
+
+    /**
+     * 按摘要获取上下文，未缓存时返回null
+     */
+    public synchronized ByteString get(String digest) {
+        return digest != null ? cache.get(digest.toLowerCase()) : null;
+    }
+
+    /**
+     * 计算上下文的SHA256摘要（小写十六进制），与Qt端CryptoWrapper::contextDigest一致
+     */
+    public static String digest(ByteString context) {
+        try {
+            MessageDigest md = MessageDigest.getInstance("SHA-256");
+            md.update(context.asReadOnlyByteBuffer());
+            byte[] hash = md.digest();
+
+            StringBuilder sb = new StringBuilder(hash.length * 2);
+            for (byte b : hash) {
+                sb.append(String.format("%02x", b));
+            }
+            return sb.toString();
+        } catch (NoSuchAlgorithmException e) {
+            throw new RuntimeException("SHA-256算法不可用", e);
+        }
+    }
+}
@@ -0,0 +1,224 @@
+package com.blacklist.grpc;
+
+import com.blacklist.common.BusinessException;
+import com.blacklist.config.PsiConfig;
+import com.blacklist.dto.SchedulerStatsDTO;
+import lombok.extern.slf4j.Slf4j;
+import org.springframework.beans.factory.annotation.Autowired;
+import org.springframework.stereotype.Component;
+
+import java.util.ArrayDeque;
+import java.util.Deque;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.locks.Condition;
+import java.util.concurrent.locks.ReentrantLock;
+
+/**
+ * PSI匹配准入调度
+ *
+ * 每次DoMatch在psisrv端都要反序列化完整的context、payload和srv_data，再加上do_matching的中间结果，
+ * 两个大查询同时到达就可能耗尽服务器内存。这里按请求大小估算内存占用，
+ * 在配置的内存预算内放行，超出预算的请求排队等待。
+ *
+ * 队列分两条：payload不超过阈值的小查询走优先队列，有优先请求等待时优先放行；
+ * 批量请求等待期间最多连续放行BULK_AGING_ADMISSIONS个优先请求，之后队首的批量请求先行，
+ * 避免优先请求持续到达时批量请求一直得不到执行。同一队列内按到达顺序放行。
+ */
+@Slf4j
+@Component
+public class MatchScheduler {
+
+    /**
+     * 批量请求等待期间最多连续放行的优先请求数
+     */
+    private static final int BULK_AGING_ADMISSIONS = 4;
+
+    @Autowired
+    private PsiConfig psiConfig;
+
+    private final ReentrantLock lock = new ReentrantLock();
+    private final Deque<Ticket> priorityQueue = new ArrayDeque<>();
+    private final Deque<Ticket> bulkQueue = new ArrayDeque<>();
+
+    // 以下字段均由lock保护
+    private long inUseBytes;
+    private int running;
+    private long admittedTotal;
+    private long rejectedTotal;
+    private long totalWaitMillis;
+    private long maxWaitMillis;
+    private int priorityStreak;   // 批量请求等待期间已连续放行的优先请求数
+
+    /**
+     * 一个等待中的请求
+     */
+    private static class Ticket {
+        final long bytes;
+        final Condition granted;
+        boolean admitted;
+
+        Ticket(long bytes, Condition granted) {
+            this.bytes = bytes;
+            this.granted = granted;
+        }
+    }
+
+    /**
+     * 已放行的请求，关闭时归还预算
+     */
+    public class Permit implements AutoCloseable {
+        private final long bytes;
+        private boolean released;
+
+        private Permit(long bytes) {
+            this.bytes = bytes;
+        }
+
+        @Override
+        public void close() {
+            lock.lock();
+            try {
+                if (!released) {
+                    released = true;
+                    inUseBytes -= bytes;
+                    running--;
+                    dispatch();
+                }
+            } finally {
+                lock.unlock();
+            }
+        }
+    }
+
+    /**
+     * 估算一次匹配在psisrv端的内存占用
+     *
+     * 两个系数都是粗略估计，未在psisrv上实测标定：假设srv_data反序列化为map后约为序列化大小的2倍，
+     * payload除自身外还对应同等规模的中间密文和结果密文（按3倍计）。
+     */
+    public static long estimateBytes(long contextBytes, long payloadBytes, long srvDataBytes) {
+        return contextBytes + payloadBytes * 3 + srvDataBytes * 2;
+    }
+
+    /**
+     * 申请执行一次匹配，预算不足时排队等待
+     * @param estimatedBytes 估算的内存占用（超过预算时按整个预算计，保证总能单独执行）
+     * @param payloadBytes   payload大小，用于判断是否走优先队列
+     */
+    public Permit acquire(long estimatedBytes, long payloadBytes) {
+        long budget = budgetBytes();
+        long bytes = budget > 0 ? Math.min(estimatedBytes, budget) : 0;
+        boolean priority = payloadBytes <= psiConfig.getPriorityPayloadBytes();
+        long startTime = System.currentTimeMillis();
+
+        lock.lock();
+        try {
+            Ticket ticket = new Ticket(bytes, lock.newCondition());
+            (priority ? priorityQueue : bulkQueue).addLast(ticket);
+            dispatch();
+
+            long remaining = TimeUnit.SECONDS.toNanos(psiConfig.getQueueTimeoutSeconds());
+            try {
+                while (!ticket.admitted) {
+                    if (remaining <= 0) {
+                        (priority ? priorityQueue : bulkQueue).remove(ticket);
+                        dispatch();
+                        rejectedTotal++;
+                        log.warn("匹配请求排队超时，估算内存: {} 字节, 优先: {}, 排队: {}/{}",
+                                bytes, priority, priorityQueue.size(), bulkQueue.size());
+                        throw new BusinessException(503, "服务器繁忙，请稍后重试");
+                    }
+                    remaining = ticket.granted.awaitNanos(remaining);
+                }
+            } catch (InterruptedException e) {
+                if (ticket.admitted) {
+                    inUseBytes -= bytes;
+                    running--;
+                    dispatch();
+                } else {
+                    (priority ? priorityQueue : bulkQueue).remove(ticket);
+                    dispatch();
+                }
+                Thread.currentThread().interrupt();
+                throw new BusinessException("匹配请求被中断");
+            }
+
+            long waitMillis = System.currentTimeMillis() - startTime;
+            admittedTotal++;
+            totalWaitMillis += waitMillis;
+            maxWaitMillis = Math.max(maxWaitMillis, waitMillis);
+
+            log.info("匹配请求已放行，估算内存: {} 字节, 优先: {}, 等待: {}ms, 占用: {}/{} 字节",
+                    bytes, priority, waitMillis, inUseBytes, budget);
+            return new Permit(bytes);
+        } finally {
+            lock.unlock();
+        }
+    }
+
+    /**
+     * 当前调度状态
+     */
+    public SchedulerStatsDTO getStats() {
+        lock.lock();
+        try {
+            SchedulerStatsDTO stats = new SchedulerStatsDTO();
+            stats.setBudgetBytes(budgetBytes());
+            stats.setInUseBytes(inUseBytes);
+            stats.setRunning(running);
+            stats.setPriorityQueueDepth(priorityQueue.size());
+            stats.setBulkQueueDepth(bulkQueue.size());
+            stats.setAdmittedTotal(admittedTotal);
+            stats.setRejectedTotal(rejectedTotal);
+            stats.setTotalWaitMillis(totalWaitMillis);
+            stats.setMaxWaitMillis(maxWaitMillis);
+            return stats;
+        } finally {
+            lock.unlock();
+        }
+    }
+
+    /**
+     * 按队列顺序放行预算内的请求（调用方需持有lock）
+     *
+     * 队首请求放不下时停止放行，不让后面的小请求插队，保证队首请求最终能凑够预算。
+     */
+    private void dispatch() {
+        while (true) {
+            Deque<Ticket> queue;
+            if (!bulkQueue.isEmpty() && (priorityQueue.isEmpty() || priorityStreak >= BULK_AGING_ADMISSIONS)) {
+                queue = bulkQueue;
+            } else if (!priorityQueue.isEmpty()) {
+                queue = priorityQueue;
+            } else {
+                return;
+            }
+
+            if (!admit(queue.peekFirst())) {
+                return;
+            }
+            queue.pollFirst();
+            if (queue == bulkQueue) {
+                priorityStreak = 0;
+            } else {
+                priorityStreak = bulkQueue.isEmpty() ? 0 : priorityStreak + 1;
+            }
+        }
+    }
+
+    private boolean admit(Ticket ticket) {
+        long budget = budgetBytes();
+        if (budget > 0 && running > 0 && inUseBytes + ticket.bytes > budget) {
+            return false;
+        }
+        inUseBytes += ticket.bytes;
+        running++;
+        ticket.admitted = true;
+        ticket.granted.signal();
+        return true;
+    }
+
+    private long budgetBytes() {
+        return psiConfig.getMemoryBudgetMb() * 1024 * 1024;
+    }
+}
@@ -1,6 +1,7 @@
 package com.blacklist.grpc;
 
 import com.blacklist.config.GrpcConfig;
+import com.blacklist.config.PsiConfig;
 import com.blacklist.dto.BlacklistFullInfo;
 import com.blacklist.util.BlacklistBitEncoder;
 import com.blacklist.util.IdCardHashUtil;
@@ -16,11 +17,21 @@ import psi.Psi;
 
 import javax.annotation.PostConstruct;
 import javax.annotation.PreDestroy;
+import java.util.ArrayList;
 import java.util.Base64;
-import java.util.HashMap;
+import java.util.Collections;
 import java.util.List;
 import java.util.Map;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.CompletionException;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.ForkJoinPool;
 import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+import java.util.stream.Collectors;
 
 @Slf4j
 @Component
@@ -29,31 +40,81 @@ public class PSIGrpcClient {
     @Autowired
     private GrpcConfig grpcConfig;
 
-    private ManagedChannel channel;
-    private PSIServiceGrpc.PSIServiceBlockingStub blockingStub;
+    @Autowired
+    private PsiConfig psiConfig;
+
+    @Autowired
+    private MatchScheduler matchScheduler;
+
+    @Autowired
+    private PsiMetrics psiMetrics;
+
+    /**
+     * 单个psisrv节点的连接
+     */
+    private static class Shard {
+        final String target;
+        final ManagedChannel channel;
+        final PSIServiceGrpc.PSIServiceBlockingStub blockingStub;
+
+        Shard(String target) {
+            this.target = target;
+            this.channel = ManagedChannelBuilder
+                    .forTarget(target)
+                    .usePlaintext()
+                    .maxInboundMessageSize(100 * 1024 * 1024)  // 100MB
+                    .build();
+            this.blockingStub = PSIServiceGrpc.newBlockingStub(channel);
+        }
+    }
+
+    private List<Shard> shards;
+
+    // 多分片时并发下发请求的线程池（每个分片一个线程）
+    private ExecutorService fanOutExecutor;
+
+    // 最近一次划分的srv_data模板及其分片结果，模板未变化时直接复用
+    private Psi.MatchRequest partitionedTemplate;
+    private List<Psi.MatchRequest> partitions;
 
     @PostConstruct
     public void init() {
-        log.info("初始化gRPC客户端，连接到 {}:{}", grpcConfig.getAddress(), grpcConfig.getPort());
+        List<String> targets = grpcConfig.getShards();
+        if (targets == null || targets.isEmpty()) {
+            targets = Collections.singletonList(grpcConfig.getAddress() + ":" + grpcConfig.getPort());
+        }
+        log.info("初始化gRPC客户端，连接到 {}", targets);
 
-        channel = ManagedChannelBuilder
-                .forAddress(grpcConfig.getAddress(), grpcConfig.getPort())
-                .usePlaintext()
-                .maxInboundMessageSize(100 * 1024 * 1024)  // 100MB
-                .build();
+        shards = new ArrayList<>(targets.size());
+        for (String target : targets) {
+            shards.add(new Shard(target));
+        }
 
-        blockingStub = PSIServiceGrpc.newBlockingStub(channel);
+        if (shards.size() > 1) {
+            AtomicInteger threadIndex = new AtomicInteger();
+            fanOutExecutor = Executors.newFixedThreadPool(shards.size(), r -> {
+                Thread t = new Thread(r, "psi-shard-" + threadIndex.getAndIncrement());
+                t.setDaemon(true);
+                return t;
+            });
+            log.info("分片模式，分片数: {}", shards.size());
+        }
 
         log.info("gRPC客户端初始化完成");
     }
 
     @PreDestroy
     public void shutdown() {
+        if (fanOutExecutor != null) {
+            fanOutExecutor.shutdownNow();
+        }
         try {
-            if (channel != null && !channel.isShutdown()) {
-                channel.shutdown().awaitTermination(5, TimeUnit.SECONDS);
-                log.info("gRPC客户端已关闭");
+            for (Shard shard : shards) {
+                if (!shard.channel.isShutdown()) {
+                    shard.channel.shutdown().awaitTermination(5, TimeUnit.SECONDS);
+                }
             }
+            log.info("gRPC客户端已关闭");
         } catch (InterruptedException e) {
             log.error("关闭gRPC客户端失败", e);
             Thread.currentThread().interrupt();
@@ -62,92 +123,124 @@ public class PSIGrpcClient {
 
     /**
      * 执行PSI匹配（使用位编码方案）
+     *
+     * 配置了多个分片时，srv_data按身份证哈希前缀划分到各psisrv节点，
+     * 同一份context/payload并发发往全部分片，各分片结果按分片顺序返回，由客户端分别解密后合并。
+     * 发往psisrv前先经MatchScheduler按估算内存排队，避免并发大查询耗尽服务器内存。
+     *
+     * @param context     已解码的客户端上下文（可能来自ContextCache）
+     * @param srvTemplate 只含srv_data的请求模板（由SrvDataCache提供）
+     * @return 各分片的Base64编码结果（单节点时只有一个）
      */
-    public String doMatch(String contextData, String payloadData, List<BlacklistFullInfo> blacklistData) {
-        try {
-            log.info("========================================");
-            log.info("开始gRPC调用");
-            log.info("黑名单数据量: {}", blacklistData.size());
-
-            // 1. 解码Base64数据
-            byte[] contextBytes = Base64.getDecoder().decode(contextData);
-            byte[] payloadBytes = Base64.getDecoder().decode(payloadData);
-
-            log.info("Context字节数: {}", contextBytes.length);
-            log.info("Payload字节数: {}", payloadBytes.length);
-
-            // 2. 转换黑名单数据为srv_data格式
-            log.info("开始转换srv_data...");
-            Map<Long, Psi.LabelsType> srvData = convertBlacklistToSrvData(blacklistData);
-
-            log.info("srv_data大小: {}", srvData.size());
-
-            // 🔥 3. 验证srv_data内容（发送前检查）
-            log.info("========== 发送前验证 ==========");
-            int verifyCount = 0;
-            for (Map.Entry<Long, Psi.LabelsType> entry : srvData.entrySet()) {
-                if (verifyCount >= 3) break;
-
-                Long key = entry.getKey();
-                Psi.LabelsType labels = entry.getValue();
-
-                log.info("srv_data[{}]:", verifyCount);
-                log.info("  key(hash): {}", key);
-                log.info("  labels.count: {}", labels.getLabelsCount());
+    public List<String> doMatch(ByteString context, String payloadData, Psi.MatchRequest srvTemplate) {
+        long decodeStart = System.nanoTime();
+        byte[] payloadBytes = Base64.getDecoder().decode(payloadData);
+        psiMetrics.record("payload_decode", decodeStart);
+
+        // 各分片内存独立，按单个分片承担的srv_data估算
+        long estimatedBytes = MatchScheduler.estimateBytes(
+                context.size(), payloadBytes.length, srvTemplate.getSerializedSize() / shards.size());
+        long waitStart = System.nanoTime();
+        try (MatchScheduler.Permit ignored = matchScheduler.acquire(estimatedBytes, payloadBytes.length)) {
+            psiMetrics.record("queue_wait", waitStart);
+            return doMatchAll(context, payloadBytes, srvTemplate);
+        }
+    }
 
-                if (labels.getLabelsCount() > 0) {
-                    long firstLabel = labels.getLabels(0);
-                    log.info("  labels[0]: {}", firstLabel);
-                    log.info("  labels[0] (hex): 0x{}", Long.toHexString(firstLabel));
-                    log.info("  labels[0] (binary): {}", Long.toBinaryString(firstLabel));
+    private List<String> doMatchAll(ByteString context, byte[] payloadBytes, Psi.MatchRequest srvTemplate) {
+        if (shards.size() == 1) {
+            return Collections.singletonList(doMatch(shards.get(0), context, payloadBytes, srvTemplate));
+        }
 
-                    // 验证解码
-                    int level = (int)(firstLabel & 0xFF);
-                    int count = (int)((firstLabel >> 8) & 0xFF);
-                    log.info("  验证解码: 评级={}, 记录数={}", level, count);
-                }
+        List<Psi.MatchRequest> parts = partition(srvTemplate);
+        List<CompletableFuture<String>> futures = new ArrayList<>(shards.size());
+        for (int i = 0; i < shards.size(); i++) {
+            Shard shard = shards.get(i);
+            Psi.MatchRequest part = parts.get(i);
+            if (part.getSrvDataCount() == 0) {
+                log.info("分片 {} 无数据，跳过", shard.target);
+                continue;
+            }
+            futures.add(CompletableFuture.supplyAsync(
+                    () -> doMatch(shard, context, payloadBytes, part), fanOutExecutor));
+        }
 
-                verifyCount++;
+        List<String> results = new ArrayList<>(futures.size());
+        try {
+            for (CompletableFuture<String> future : futures) {
+                results.add(future.join());
             }
-            log.info("================================");
-
-            // 4. 构建请求
-            log.info("构建gRPC请求...");
-            Psi.MatchRequest request = Psi.MatchRequest.newBuilder()
-                    .setContextData(ByteString.copyFrom(contextBytes))
-                    .setPayloadData(ByteString.copyFrom(payloadBytes))
-                    .putAllSrvData(srvData)
-                    .build();
+        } catch (CompletionException e) {
+            futures.forEach(f -> f.cancel(true));
+            if (e.getCause() instanceof RuntimeException) {
+                throw (RuntimeException) e.getCause();
+            }
+            throw e;
+        }
+        return results;
+    }
 
-            log.info("请求大小: {} 字节", request.getSerializedSize());
+    /**
+     * 按身份证哈希前缀把srv_data划分到各分片
+     */
+    private synchronized List<Psi.MatchRequest> partition(Psi.MatchRequest srvTemplate) {
+        if (srvTemplate == partitionedTemplate) {
+            return partitions;
+        }
 
-            // 🔥 5. 打印请求中的srv_data（确认序列化正确）
-            log.info("========== 请求中的srv_data验证 ==========");
-            Map<Long, Psi.LabelsType> requestSrvData = request.getSrvDataMap();
-            log.info("request.srv_data.size: {}", requestSrvData.size());
+        long startTime = System.currentTimeMillis();
+        int shardCount = shards.size();
+        List<Psi.MatchRequest.Builder> builders = new ArrayList<>(shardCount);
+        for (int i = 0; i < shardCount; i++) {
+            builders.add(Psi.MatchRequest.newBuilder());
+        }
+        for (Map.Entry<Long, Psi.LabelsType> entry : srvTemplate.getSrvDataMap().entrySet()) {
+            builders.get(shardOf(entry.getKey(), shardCount)).putSrvData(entry.getKey(), entry.getValue());
+        }
 
-            verifyCount = 0;
-            for (Map.Entry<Long, Psi.LabelsType> entry : requestSrvData.entrySet()) {
-                if (verifyCount >= 3) break;
+        List<Psi.MatchRequest> result = new ArrayList<>(shardCount);
+        for (int i = 0; i < shardCount; i++) {
+            result.add(builders.get(i).build());
+            log.info("分片 {} 数据量: {}", shards.get(i).target, result.get(i).getSrvDataCount());
+        }
+        log.info("srv_data分片完成，耗时: {}ms", System.currentTimeMillis() - startTime);
 
-                log.info("request.srv_data[{}]:", verifyCount);
-                log.info("  key: {}", entry.getKey());
-                log.info("  labels: {}", entry.getValue().getLabelsList());
+        this.partitionedTemplate = srvTemplate;
+        this.partitions = result;
+        return result;
+    }
 
-                verifyCount++;
-            }
-            log.info("==========================================");
+    /**
+     * 哈希值所属分片：取高32位前缀按区间均分，同一前缀区间固定落在同一分片
+     */
+    static int shardOf(long key, int shardCount) {
+        return (int) (((key >>> 32) * shardCount) >>> 32);
+    }
+
+    /**
+     * 向单个psisrv节点执行匹配
+     */
+    private String doMatch(Shard shard, ByteString context, byte[] payloadBytes, Psi.MatchRequest srvTemplate) {
+        long startNanos = System.nanoTime();
+        try {
+            log.info("========================================");
+            log.info("开始gRPC调用: {}", shard.target);
+            log.info("黑名单数据量: {}", srvTemplate.getSrvDataCount());
 
-            log.info("调用C++服务器...");
+            log.info("Context字节数: {}", context.size());
+            log.info("Payload字节数: {}", payloadBytes.length);
+            psiMetrics.addBytesSent(context.size() + payloadBytes.length + srvTemplate.getSerializedSize());
 
-            // 6. 调用gRPC（设置3分钟超时）
-            Psi.EncryptResponse response = blockingStub
+            // 调用gRPC（设置3分钟超时）
+            Psi.EncryptResponse response = shard.blockingStub
                     .withDeadlineAfter(3, TimeUnit.MINUTES)
-                    .doMatch(request);
+                    .doMatch(buildRequest(context, payloadBytes, srvTemplate));
 
-            // 7. 返回Base64编码的结果
+            // 返回Base64编码的结果
             byte[] resultBytes = response.getPayloadData().toByteArray();
             String resultBase64 = Base64.getEncoder().encodeToString(resultBytes);
+            psiMetrics.record("grpc", startNanos);
+            psiMetrics.addBytesReceived(resultBytes.length);
 
             log.info("gRPC调用成功！");
             log.info("返回结果字节数: {}", resultBytes.length);
@@ -169,66 +262,97 @@ public class PSIGrpcClient {
     }
 
     /**
-     * 将黑名单完整信息转换为srv_data格式（使用位编码）
+     * 在缓存的srv_data模板上补充本次查询的context/payload
+     */
+    private Psi.MatchRequest buildRequest(ByteString context, byte[] payloadBytes, Psi.MatchRequest srvTemplate) {
+        log.info("构建gRPC请求...");
+        Psi.MatchRequest request = srvTemplate.toBuilder()
+                .setContextData(context)
+                .setPayloadData(ByteString.copyFrom(payloadBytes))
+                .build();
+
+        log.info("请求大小: {} 字节", request.getSerializedSize());
+        log.info("调用C++服务器...");
+        return request;
+    }
+
+    /**
+     * 将黑名单完整信息转换为srv_data格式（单label紧凑方案）
      *
      * Map结构：
      * key = 身份证号哈希值
-     * value = LabelsType { labels: [编码后的完整信息] }
-     */
-    /**
-     * 将黑名单完整信息转换为srv_data格式（多labels方案）
+     * value = LabelsType { labels: [打包后的完整信息] }
+     *
+     * 哈希与编码在独立的ForkJoinPool上并行执行（工作窃取），
+     * 线程数由 blacklist.psi.convert-threads 配置，0表示使用全部CPU核数。
      */
-    private Map<Long, Psi.LabelsType> convertBlacklistToSrvData(List<BlacklistFullInfo> blacklistData) {
-        Map<Long, Psi.LabelsType> srvData = new HashMap<>();
-
+    public Map<Long, Psi.LabelsType> convertBlacklistToSrvData(List<BlacklistFullInfo> blacklistData) {
         log.info("---------- srv_data 转换详情 ----------");
 
-        for (int i = 0; i < blacklistData.size(); i++) {
+        // 打印前3条的详细信息
+        for (int i = 0; i < blacklistData.size() && i < 3; i++) {
             BlacklistFullInfo info = blacklistData.get(i);
-
-            // 计算身份证哈希值作为key
             long idCardHash = IdCardHashUtil.hashIdCard(info.getMain().getIdCard());
-
-            // 编码为labels数组
             long[] labels = BlacklistBitEncoder.encodeBlacklistInfoToLabels(info);
 
-            // 构建LabelsType
-            Psi.LabelsType.Builder labelsBuilder = Psi.LabelsType.newBuilder();
-            for (long label : labels) {
-                labelsBuilder.addLabels(label);
-            }
-            Psi.LabelsType labelsType = labelsBuilder.build();
-
-            srvData.put(idCardHash, labelsType);
-
-            // 打印前3条的详细信息
-            if (i < 3) {
-                log.info("  [{}] 身份证={}, hash={}",
-                        i, info.getMain().getIdCard(), idCardHash);
-                log.info("       labels数量: {}", labels.length);
-                log.info("       labels[0]: {} (评级={}, 记录数={})",
-                        labels[0],
-                        info.getMain().getRiskLevel().getDescription(),
-                        info.getMain().getRecordCount());
-
-                for (int j = 0; j < info.getRecords().size(); j++) {
-                    var rec = info.getRecords().get(j);
-                    log.info("       labels[{}]: {} ({}(code={}) + {}(code={}))",
-                            j + 1,
-                            labels[j + 1],
-                            rec.getBehaviorType().getDescription(),
-                            rec.getBehaviorType().getCode(),
-                            rec.getTool().getDescription(),
-                            rec.getTool().getCode());
-                }
+            log.info("  [{}] 身份证={}, hash={}",
+                    i, info.getMain().getIdCard(), idCardHash);
+            log.info("       label: {} (评级={}, 记录数={})",
+                    labels[0],
+                    info.getMain().getRiskLevel().getDescription(),
+                    info.getMain().getRecordCount());
+
+            for (int j = 0; j < info.getRecords().size(); j++) {
+                var rec = info.getRecords().get(j);
+                log.info("       记录{}: {}(code={}) + {}(code={})",
+                        j + 1,
+                        rec.getBehaviorType().getDescription(),
+                        rec.getBehaviorType().getCode(),
+                        rec.getTool().getDescription(),
+                        rec.getTool().getCode());
             }
         }
 
-        log.info("--------------------------------------");
-        log.info("srv_data转换完成，共 {} 条", srvData.size());
+        int threads = psiConfig.getConvertThreads() > 0
+                ? psiConfig.getConvertThreads()
+                : Runtime.getRuntime().availableProcessors();
+        long startTime = System.currentTimeMillis();
 
-        return srvData;
+        ForkJoinPool pool = new ForkJoinPool(threads);
+        try {
+            Map<Long, Psi.LabelsType> srvData = pool.submit(() -> blacklistData.parallelStream()
+                    .collect(Collectors.toConcurrentMap(
+                            info -> IdCardHashUtil.hashIdCard(info.getMain().getIdCard()),
+                            PSIGrpcClient::encodeLabels,
+                            (a, b) -> b,
+                            () -> new ConcurrentHashMap<>(blacklistData.size() * 4 / 3 + 1)
+                    ))).get();
+
+            log.info("--------------------------------------");
+            log.info("srv_data转换完成，共 {} 条，线程数: {}, 耗时: {}ms",
+                    srvData.size(), threads, System.currentTimeMillis() - startTime);
+
+            return srvData;
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+            throw new RuntimeException("srv_data转换被中断", e);
+        } catch (ExecutionException e) {
+            throw new RuntimeException("srv_data转换失败: " + e.getCause().getMessage(), e.getCause());
+        } finally {
+            pool.shutdown();
+        }
     }
 
+    /**
+     * 编码单条黑名单信息为LabelsType
+     */
+    public static Psi.LabelsType encodeLabels(BlacklistFullInfo info) {
+        long[] labels = BlacklistBitEncoder.encodeBlacklistInfoToLabels(info);
 
+        Psi.LabelsType.Builder labelsBuilder = Psi.LabelsType.newBuilder();
+        for (long label : labels) {
+            labelsBuilder.addLabels(label);
+        }
+        return labelsBuilder.build();
+    }
 }
\ No newline at end of file
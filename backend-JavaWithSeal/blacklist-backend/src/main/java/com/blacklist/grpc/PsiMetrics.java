@@ -0,0 +1,166 @@
+package com.blacklist.grpc;
+
+import com.blacklist.dto.SchedulerStatsDTO;
+import org.springframework.beans.factory.annotation.Autowired;
+import org.springframework.stereotype.Component;
+
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ConcurrentSkipListMap;
+import java.util.concurrent.atomic.AtomicInteger;
+import java.util.concurrent.atomic.DoubleAdder;
+import java.util.concurrent.atomic.LongAdder;
+
+/**
+ * PSI查询指标（Prometheus文本格式）
+ *
+ * psisrv内部不可观测，这里在后端按阶段记录每次查询的耗时直方图：
+ *   srv_data       黑名单版本查询 + srv_data缓存/快照/重建
+ *   context        上下文解码或按摘要取缓存
+ *   payload_decode payload Base64解码
+ *   queue_wait     MatchScheduler排队等待
+ *   grpc           单个psisrv分片的匹配调用（含请求序列化、psisrv计算和结果接收）
+ *   total          整个查询
+ * 另外统计发往/收自psisrv的字节数、进行中的查询数和失败数，以及调度器状态。
+ */
+@Component
+public class PsiMetrics {
+
+    // 直方图桶上限（毫秒）
+    private static final double[] BUCKETS_MS = {
+            5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 30000, 60000, 180000
+    };
+
+    @Autowired
+    private MatchScheduler matchScheduler;
+
+    private final Map<String, Histogram> phases = new ConcurrentHashMap<>();
+    private final LongAdder bytesSent = new LongAdder();
+    private final LongAdder bytesReceived = new LongAdder();
+    private final LongAdder queriesTotal = new LongAdder();
+    private final LongAdder queryErrorsTotal = new LongAdder();
+    private final AtomicInteger activeQueries = new AtomicInteger();
+
+    /**
+     * 单个阶段的耗时直方图
+     */
+    private static class Histogram {
+        final LongAdder[] buckets = new LongAdder[BUCKETS_MS.length];
+        final LongAdder count = new LongAdder();
+        final DoubleAdder sum = new DoubleAdder();
+
+        Histogram() {
+            for (int i = 0; i < buckets.length; i++) {
+                buckets[i] = new LongAdder();
+            }
+        }
+
+        void observe(double millis) {
+            for (int i = 0; i < BUCKETS_MS.length; i++) {
+                if (millis <= BUCKETS_MS[i]) {
+                    buckets[i].increment();
+                    break;
+                }
+            }
+            count.increment();
+            sum.add(millis);
+        }
+    }
+
+    /**
+     * 记录一个阶段的耗时
+     * @param phase     阶段名
+     * @param startNanos 阶段开始时的System.nanoTime()
+     */
+    public void record(String phase, long startNanos) {
+        double millis = (System.nanoTime() - startNanos) / 1_000_000.0;
+        phases.computeIfAbsent(phase, k -> new Histogram()).observe(millis);
+    }
+
+    public void addBytesSent(long bytes) {
+        bytesSent.add(bytes);
+    }
+
+    public void addBytesReceived(long bytes) {
+        bytesReceived.add(bytes);
+    }
+
+    public void queryStarted() {
+        queriesTotal.increment();
+        activeQueries.incrementAndGet();
+    }
+
+    public void queryFinished(boolean success) {
+        activeQueries.decrementAndGet();
+        if (!success) {
+            queryErrorsTotal.increment();
+        }
+    }
+
+    /**
+     * 输出Prometheus文本格式
+     */
+    public String scrape() {
+        StringBuilder sb = new StringBuilder(4096);
+
+        sb.append("# HELP psi_phase_duration_ms PSI查询各阶段耗时（毫秒）\n");
+        sb.append("# TYPE psi_phase_duration_ms histogram\n");
+        for (Map.Entry<String, Histogram> entry : new ConcurrentSkipListMap<>(phases).entrySet()) {
+            String phase = entry.getKey();
+            Histogram h = entry.getValue();
+            long cumulative = 0;
+            for (int i = 0; i < BUCKETS_MS.length; i++) {
+                cumulative += h.buckets[i].sum();
+                sb.append("psi_phase_duration_ms_bucket{phase=\"").append(phase)
+                        .append("\",le=\"").append(formatBound(BUCKETS_MS[i])).append("\"} ")
+                        .append(cumulative).append('\n');
+            }
+            long count = h.count.sum();
+            sb.append("psi_phase_duration_ms_bucket{phase=\"").append(phase).append("\",le=\"+Inf\"} ")
+                    .append(count).append('\n');
+            sb.append("psi_phase_duration_ms_sum{phase=\"").append(phase).append("\"} ")
+                    .append(h.sum.sum()).append('\n');
+            sb.append("psi_phase_duration_ms_count{phase=\"").append(phase).append("\"} ")
+                    .append(count).append('\n');
+        }
+
+        counter(sb, "psi_grpc_bytes_sent_total", "发往psisrv的字节数", bytesSent.sum());
+        counter(sb, "psi_grpc_bytes_received_total", "从psisrv收到的字节数", bytesReceived.sum());
+        counter(sb, "psi_queries_total", "查询总数", queriesTotal.sum());
+        counter(sb, "psi_query_errors_total", "失败查询数", queryErrorsTotal.sum());
+        gauge(sb, "psi_active_queries", "进行中的查询数", activeQueries.get());
+
+        SchedulerStatsDTO stats = matchScheduler.getStats();
+        gauge(sb, "psi_scheduler_budget_bytes", "匹配内存预算（0表示不限制）", stats.getBudgetBytes());
+        gauge(sb, "psi_scheduler_in_use_bytes", "已放行请求的估算内存占用", stats.getInUseBytes());
+        gauge(sb, "psi_scheduler_running", "正在执行的匹配数", stats.getRunning());
+        sb.append("# HELP psi_scheduler_queue_depth 调度队列排队数\n");
+        sb.append("# TYPE psi_scheduler_queue_depth gauge\n");
+        sb.append("psi_scheduler_queue_depth{lane=\"priority\"} ").append(stats.getPriorityQueueDepth()).append('\n');
+        sb.append("psi_scheduler_queue_depth{lane=\"bulk\"} ").append(stats.getBulkQueueDepth()).append('\n');
+        counter(sb, "psi_scheduler_admitted_total", "累计放行数", stats.getAdmittedTotal());
+        counter(sb, "psi_scheduler_rejected_total", "累计排队超时数", stats.getRejectedTotal());
+        counter(sb, "psi_scheduler_wait_ms_total", "累计排队等待时间（毫秒）", stats.getTotalWaitMillis());
+        gauge(sb, "psi_scheduler_max_wait_ms", "最长排队等待时间（毫秒）", stats.getMaxWaitMillis());
+
+        return sb.toString();
+    }
+
+    private static void counter(StringBuilder sb, String name, String help, Number value) {
+        metric(sb, name, help, "counter", value);
+    }
+
+    private static void gauge(StringBuilder sb, String name, String help, Number value) {
+        metric(sb, name, help, "gauge", value);
+    }
+
+    private static void metric(StringBuilder sb, String name, String help, String type, Number value) {
+        sb.append("# HELP ").append(name).append(' ').append(help).append('\n');
+        sb.append("# TYPE ").append(name).append(' ').append(type).append('\n');
+        sb.append(name).append(' ').append(value).append('\n');
+    }
+
+    private static String formatBound(double bound) {
+        return bound == Math.rint(bound) ? String.valueOf((long) bound) : String.valueOf(bound);
+    }
+}
@@ -0,0 +1,219 @@
+package com.blacklist.grpc;
+
+import lombok.extern.slf4j.Slf4j;
+import org.springframework.beans.factory.annotation.Autowired;
+import org.springframework.stereotype.Component;
+import psi.Psi;
+
+import java.nio.file.Path;
+import java.util.Collection;
+import java.util.HashMap;
+import java.util.HashSet;
+import java.util.Map;
+import java.util.Set;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.function.Supplier;
+
+/**
+ * 已编码srv_data缓存
+ *
+ * 黑名单数据只在重新创建时变化，查询时不必每次都回库读取、哈希、编码。
+ * 这里按黑名单版本号缓存一个只含srv_data的MatchRequest模板，
+ * 查询时在模板上补充context/payload即可。
+ * 内存未命中时优先加载同版本的磁盘快照，后端重启后不必回库重建。
+ *
+ * 单条增删改在事务提交后通过applyUpdates记录为增量，只占用与改动条数成正比的时间；
+ * 增量在下一次查询时一次性合并进模板，合并后的快照在后台线程重新落盘。
+ * 合并需要复制整个srv_data（O(n)），但不论之间有多少次改动，每次查询最多合并一次，
+ * 而该查询本身就要序列化整个srv_data发给psisrv，因此不改变查询的复杂度。
+ */
+@Slf4j
+@Component
+public class SrvDataCache {
+
+    @Autowired
+    private SrvDataSnapshotStore snapshotStore;
+
+    private String version;
+    private Psi.MatchRequest template;
+
+    // 每次增量或失效加1，后台快照提交前据此判断是否已过期
+    private long generation;
+
+    // 正在进行的增删改事务数，以及这些事务是否有重叠
+    private int activeWriters;
+    private boolean writersOverlapped;
+
+    // 尚未合并进模板的增量
+    private final Map<Long, Psi.LabelsType> pendingPuts = new HashMap<>();
+    private final Set<Long> pendingRemoves = new HashSet<>();
+
+    // 快照落盘线程（单线程保证按合并顺序写入）
+    private final ExecutorService snapshotWriter = Executors.newSingleThreadExecutor(r -> {
+        Thread t = new Thread(r, "srvdata-snapshot");
+        t.setDaemon(true);
+        return t;
+    });
+
+    /**
+     * 获取指定版本的srv_data模板，版本不一致时调用loader重建
+     * @param version 黑名单版本号
+     * @param loader  构建srv_data的回调
+     */
+    public synchronized Psi.MatchRequest getOrLoad(String version, Supplier<Map<Long, Psi.LabelsType>> loader) {
+        if (template != null && version.equals(this.version)) {
+            if (!pendingPuts.isEmpty() || !pendingRemoves.isEmpty()) {
+                mergePending();
+            }
+            log.info("命中srv_data缓存，版本: {}, 数据量: {}", version, template.getSrvDataCount());
+            return template;
+        }
+
+        Psi.MatchRequest snapshot = snapshotStore.load(version);
+        if (snapshot != null) {
+            this.template = snapshot;
+            this.version = version;
+            return template;
+        }
+
+        log.info("srv_data缓存未命中，重建版本: {} (原版本: {})", version, this.version);
+        long startTime = System.currentTimeMillis();
+
+        install(version, loader.get());
+
+        log.info("srv_data缓存重建完成，数据量: {}, 耗时: {}ms",
+                template.getSrvDataCount(), System.currentTimeMillis() - startTime);
+        return template;
+    }
+
+    /**
+     * 用外部构建好的srv_data替换缓存（批量导入时调用），同时写入快照
+     * @param version 黑名单版本号
+     * @param srvData 完整的srv_data
+     */
+    public synchronized void install(String version, Map<Long, Psi.LabelsType> srvData) {
+        this.template = Psi.MatchRequest.newBuilder()
+                .putAllSrvData(srvData)
+                .build();
+        this.version = version;
+        this.generation++;
+        pendingPuts.clear();
+        pendingRemoves.clear();
+
+        snapshotStore.save(version, template);
+    }
+
+    /**
+     * 增删改事务开始时调用，须与endUpdate成对使用
+     */
+    public synchronized void beginUpdate() {
+        if (activeWriters++ > 0) {
+            writersOverlapped = true;
+        }
+    }
+
+    /**
+     * 增删改事务结束（提交或回滚）时调用
+     */
+    public synchronized void endUpdate() {
+        if (--activeWriters == 0) {
+            writersOverlapped = false;
+        }
+    }
+
+    /**
+     * 记录单条增删改，不重建整个srv_data（事务提交后调用）
+     *
+     * 仅当缓存当前持有oldVersion、且没有与其他增删改事务重叠时才记录增量并切换到newVersion，
+     * 否则直接失效，下次查询按新版本完整重建。重叠的事务提交顺序无法确定，
+     * 同一身份证的增量可能以错误的顺序写入缓存。
+     *
+     * @param oldVersion 改动前的黑名单版本号
+     * @param newVersion 改动后的黑名单版本号
+     * @param puts       新增或重新编码的条目（key=身份证哈希）
+     * @param removes    删除的身份证哈希
+     */
+    public synchronized void applyUpdates(String oldVersion, String newVersion,
+                                          Map<Long, Psi.LabelsType> puts, Collection<Long> removes) {
+        if (template == null || !oldVersion.equals(this.version)) {
+            log.info("srv_data缓存版本不一致（缓存: {}, 改动前: {}），直接失效", this.version, oldVersion);
+            invalidate();
+            return;
+        }
+        if (writersOverlapped) {
+            log.info("存在并发的黑名单增删改，srv_data缓存直接失效");
+            invalidate();
+            return;
+        }
+
+        for (Long key : removes) {
+            pendingPuts.remove(key);
+            pendingRemoves.add(key);
+        }
+        for (Map.Entry<Long, Psi.LabelsType> entry : puts.entrySet()) {
+            pendingRemoves.remove(entry.getKey());
+            pendingPuts.put(entry.getKey(), entry.getValue());
+        }
+        this.version = newVersion;
+        this.generation++;
+
+        // 磁盘快照已过期，先删除，避免重启后加载到同版本号的旧数据
+        snapshotStore.clear();
+
+        log.info("srv_data增量更新: 新增/更新 {} 条, 删除 {} 条, 版本: {} -> {}, 待合并: {}/{}",
+                puts.size(), removes.size(), oldVersion, newVersion, pendingPuts.size(), pendingRemoves.size());
+    }
+
+    /**
+     * 使缓存失效（黑名单重建时调用），同时删除磁盘快照
+     */
+    public synchronized void invalidate() {
+        log.info("srv_data缓存失效，原版本: {}", version);
+        this.version = null;
+        this.template = null;
+        this.generation++;
+        pendingPuts.clear();
+        pendingRemoves.clear();
+        snapshotStore.clear();
+    }
+
+    /**
+     * 将待合并增量写入模板，并在后台重新写快照
+     */
+    private void mergePending() {
+        long startTime = System.currentTimeMillis();
+
+        Psi.MatchRequest.Builder builder = template.toBuilder();
+        for (Long key : pendingRemoves) {
+            builder.removeSrvData(key);
+        }
+        builder.putAllSrvData(pendingPuts);
+        this.template = builder.build();
+
+        log.info("srv_data增量合并完成: 新增/更新 {} 条, 删除 {} 条, 数据量: {}, 耗时: {}ms",
+                pendingPuts.size(), pendingRemoves.size(), template.getSrvDataCount(),
+                System.currentTimeMillis() - startTime);
+
+        pendingPuts.clear();
+        pendingRemoves.clear();
+
+        String snapshotVersion = this.version;
+        Psi.MatchRequest snapshotTemplate = this.template;
+        long snapshotGeneration = this.generation;
+        snapshotWriter.submit(() -> {
+            Path tmp = snapshotStore.writeTemp(snapshotVersion, snapshotTemplate);
+            if (tmp == null) {
+                return;
+            }
+            synchronized (this) {
+                if (generation == snapshotGeneration) {
+                    snapshotStore.commit(snapshotVersion, tmp);
+                } else {
+                    log.info("srv_data已再次变更，丢弃过期快照: {}", snapshotVersion);
+                    snapshotStore.discard(tmp);
+                }
+            }
+        });
+    }
+}
@@ -0,0 +1,328 @@
+package com.blacklist.grpc;
+
+import com.blacklist.config.PsiConfig;
+import com.blacklist.dto.BlacklistFullInfo;
+import com.blacklist.entity.BehaviorRecord;
+import com.blacklist.entity.BlacklistMain;
+import com.blacklist.enums.BehaviorLevelEnum;
+import com.blacklist.enums.BehaviorTypeEnum;
+import com.blacklist.enums.ToolTypeEnum;
+import com.blacklist.util.IdCardHashUtil;
+import lombok.Getter;
+import lombok.extern.slf4j.Slf4j;
+import org.springframework.beans.factory.annotation.Autowired;
+import org.springframework.stereotype.Component;
+import psi.Psi;
+
+import java.io.BufferedReader;
+import java.io.Closeable;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.Deque;
+import java.util.List;
+import java.util.Map;
+import java.util.concurrent.ConcurrentHashMap;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ForkJoinPool;
+import java.util.concurrent.Future;
+import java.util.function.Consumer;
+
+/**
+ * 从黑名单导出文件批量构建srv_data
+ *
+ * 直接读取blacklist_main和behavior_record的CSV/TSV导出（首行为列名），不经过MyBatis逐行查询。
+ * 两个文件都须按user_id升序导出，读取时按user_id归并，内存只保留当前批次；
+ * 哈希与编码按批次提交到ForkJoinPool并行执行，在途批次数有上限，读取不会远超编码进度。
+ *
+ * 每个批次在提交编码前先交给调用方写入数据库，缓存的版本号由调用方在写库后
+ * 按BlacklistService.getVersion读取，保证缓存内容与数据库一致。
+ */
+@Slf4j
+@Component
+public class SrvDataIngestor {
+
+    private static final int BATCH_SIZE = 65536;
+
+    @Autowired
+    private PsiConfig psiConfig;
+
+    /**
+     * 导入结果
+     */
+    @Getter
+    public static class Ingested {
+        private final Map<Long, Psi.LabelsType> srvData;
+        private final long mainCount;
+        private final long recordCount;
+
+        Ingested(Map<Long, Psi.LabelsType> srvData, long mainCount, long recordCount) {
+            this.srvData = srvData;
+            this.mainCount = mainCount;
+            this.recordCount = recordCount;
+        }
+    }
+
+    /**
+     * 读取导出文件并构建srv_data
+     * @param mainFile   blacklist_main导出（列：user_id, id_card, risk_level, record_count）
+     * @param recordFile behavior_record导出（列：user_id, behavior_type, tool）
+     * @param delimiter  列分隔符
+     * @param sink       每个批次编码前在读取线程上调用，用于写入数据库
+     */
+    public Ingested ingest(Path mainFile, Path recordFile, char delimiter,
+                           Consumer<List<BlacklistFullInfo>> sink) throws IOException {
+        int threads = psiConfig.getConvertThreads() > 0
+                ? psiConfig.getConvertThreads()
+                : Runtime.getRuntime().availableProcessors();
+        long startTime = System.currentTimeMillis();
+
+        Map<Long, Psi.LabelsType> srvData = new ConcurrentHashMap<>();
+
+        ForkJoinPool pool = new ForkJoinPool(threads);
+        Deque<Future<?>> inFlight = new ArrayDeque<>();
+        long mainCount = 0;
+        long recordCount = 0;
+
+        try (DumpReader mains = new DumpReader(mainFile, delimiter);
+             DumpReader records = new DumpReader(recordFile, delimiter)) {
+            int mUser = mains.column("user_id");
+            int mIdCard = mains.column("id_card");
+            int mRisk = mains.column("risk_level");
+            int mCount = mains.column("record_count");
+            int rUser = records.column("user_id");
+            int rType = records.column("behavior_type");
+            int rTool = records.column("tool");
+
+            String[] rec = records.next();
+            long recUser = rec != null ? parseLong(rec[rUser], records) : Long.MAX_VALUE;
+            long lastUser = Long.MIN_VALUE;
+
+            List<BlacklistFullInfo> batch = new ArrayList<>(BATCH_SIZE);
+            String[] row;
+            while ((row = mains.next()) != null) {
+                long userId = parseLong(row[mUser], mains);
+                if (userId <= lastUser) {
+                    throw new IllegalArgumentException(String.format(
+                            "%s未按user_id升序导出，第%d行: %d", mainFile.getFileName(), mains.lineNumber(), userId));
+                }
+                lastUser = userId;
+
+                BlacklistMain main = new BlacklistMain();
+                main.setUserId(userId);
+                main.setIdCard(row[mIdCard]);
+                main.setRiskLevel(requireEnum(BehaviorLevelEnum.getByCode(parseInt(row[mRisk], mains)), "risk_level", mains));
+                main.setRecordCount(parseInt(row[mCount], mains));
+
+                // 跳过没有对应主表记录的行为记录
+                while (recUser < userId) {
+                    rec = records.next();
+                    recUser = nextRecordUser(rec, rUser, recUser, records);
+                }
+
+                List<BehaviorRecord> userRecords = new ArrayList<>(3);
+                while (recUser == userId) {
+                    BehaviorRecord record = new BehaviorRecord();
+                    record.setUserId(userId);
+                    record.setBehaviorType(requireEnum(BehaviorTypeEnum.getByCode(parseInt(rec[rType], records)), "behavior_type", records));
+                    record.setTool(requireEnum(ToolTypeEnum.getByCode(parseInt(rec[rTool], records)), "tool", records));
+                    userRecords.add(record);
+                    recordCount++;
+
+                    rec = records.next();
+                    recUser = nextRecordUser(rec, rUser, recUser, records);
+                }
+
+                BlacklistFullInfo info = new BlacklistFullInfo();
+                info.setMain(main);
+                info.setRecords(userRecords);
+                batch.add(info);
+
+                mainCount++;
+
+                if (batch.size() == BATCH_SIZE) {
+                    sink.accept(batch);
+                    submit(pool, inFlight, batch, srvData, threads * 2);
+                    batch = new ArrayList<>(BATCH_SIZE);
+                }
+            }
+            if (!batch.isEmpty()) {
+                sink.accept(batch);
+                submit(pool, inFlight, batch, srvData, 0);
+            }
+            while (!inFlight.isEmpty()) {
+                inFlight.pollFirst().get();
+            }
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+            throw new IOException("导入被中断", e);
+        } catch (ExecutionException e) {
+            throw new IOException("srv_data编码失败: " + e.getCause().getMessage(), e.getCause());
+        } finally {
+            pool.shutdownNow();
+        }
+
+        log.info("导出文件导入完成，主表: {} 条，行为记录: {} 条，srv_data: {} 条，线程数: {}，耗时: {}ms",
+                mainCount, recordCount, srvData.size(), threads, System.currentTimeMillis() - startTime);
+        return new Ingested(srvData, mainCount, recordCount);
+    }
+
+    /**
+     * 提交一个批次，在途批次超过上限时先等待最早的批次完成
+     */
+    private static void submit(ForkJoinPool pool, Deque<Future<?>> inFlight, List<BlacklistFullInfo> batch,
+                               Map<Long, Psi.LabelsType> srvData, int maxInFlight)
+            throws InterruptedException, ExecutionException {
+        inFlight.addLast(pool.submit(() -> {
+            for (BlacklistFullInfo info : batch) {
+                srvData.put(IdCardHashUtil.hashIdCard(info.getMain().getIdCard()), PSIGrpcClient.encodeLabels(info));
+            }
+        }));
+        while (maxInFlight > 0 && inFlight.size() > maxInFlight) {
+            inFlight.pollFirst().get();
+        }
+    }
+
+    private static long nextRecordUser(String[] rec, int column, long previous, DumpReader reader) {
+        if (rec == null) {
+            return Long.MAX_VALUE;
+        }
+        long userId = parseLong(rec[column], reader);
+        if (userId < previous) {
+            throw new IllegalArgumentException(String.format(
+                    "%s未按user_id升序导出，第%d行: %d", reader.fileName(), reader.lineNumber(), userId));
+        }
+        return userId;
+    }
+
+    private static <T> T requireEnum(T value, String column, DumpReader reader) {
+        if (value == null) {
+            throw new IllegalArgumentException(String.format(
+                    "%s第%d行%s取值非法", reader.fileName(), reader.lineNumber(), column));
+        }
+        return value;
+    }
+
+    private static long parseLong(String value, DumpReader reader) {
+        try {
+            return Long.parseLong(value);
+        } catch (NumberFormatException e) {
+            throw new IllegalArgumentException(String.format(
+                    "%s第%d行数字格式错误: %s", reader.fileName(), reader.lineNumber(), value));
+        }
+    }
+
+    private static int parseInt(String value, DumpReader reader) {
+        return (int) parseLong(value, reader);
+    }
+
+    /**
+     * 按行读取CSV/TSV导出，首行为列名；字段不含分隔符，两端引号会被去掉
+     */
+    private static class DumpReader implements Closeable {
+        private final Path file;
+        private final BufferedReader reader;
+        private final char delimiter;
+        private final List<String> header;
+        private long lineNumber;
+
+        DumpReader(Path file, char delimiter) throws IOException {
+            this.file = file;
+            this.reader = Files.newBufferedReader(file, StandardCharsets.UTF_8);
+            this.delimiter = delimiter;
+
+            String line = reader.readLine();
+            lineNumber = 1;
+            if (line == null) {
+                throw new IllegalArgumentException(file.getFileName() + "为空");
+            }
+            if (!line.isEmpty() && line.charAt(0) == '\uFEFF') {
+                line = line.substring(1);
+            }
+            header = new ArrayList<>();
+            for (String name : split(line)) {
+                header.add(normalize(name));
+            }
+        }
+
+        int column(String name) {
+            int index = header.indexOf(normalize(name));
+            if (index < 0) {
+                throw new IllegalArgumentException(file.getFileName() + "缺少列: " + name);
+            }
+            return index;
+        }
+
+        /**
+         * 读取下一行，文件结束返回null
+         */
+        String[] next() {
+            try {
+                String line;
+                do {
+                    line = reader.readLine();
+                    lineNumber++;
+                } while (line != null && line.isEmpty());
+
+                if (line == null) {
+                    return null;
+                }
+                String[] fields = split(line);
+                if (fields.length < header.size()) {
+                    throw new IllegalArgumentException(String.format(
+                            "%s第%d行列数不足: %d/%d", file.getFileName(), lineNumber, fields.length, header.size()));
+                }
+                return fields;
+            } catch (IOException e) {
+                throw new IllegalStateException("读取" + file.getFileName() + "失败", e);
+            }
+        }
+
+        long lineNumber() {
+            return lineNumber;
+        }
+
+        String fileName() {
+            return file.getFileName().toString();
+        }
+
+        private String[] split(String line) {
+            List<String> fields = new ArrayList<>(8);
+            int start = 0;
+            for (int i = 0; i <= line.length(); i++) {
+                if (i == line.length() || line.charAt(i) == delimiter) {
+                    fields.add(unquote(line, start, i));
+                    start = i + 1;
+                }
+            }
+            return fields.toArray(new String[0]);
+        }
+
+        private static String unquote(String line, int start, int end) {
+            while (start < end && Character.isWhitespace(line.charAt(start))) {
+                start++;
+            }
+            while (end > start && Character.isWhitespace(line.charAt(end - 1))) {
+                end--;
+            }
+            if (end - start >= 2 && line.charAt(start) == '"' && line.charAt(end - 1) == '"') {
+                start++;
+                end--;
+            }
+            return line.substring(start, end);
+        }
+
+        // user_id / userId / USER_ID 视为同一列
+        private static String normalize(String name) {
+            return unquote(name, 0, name.length()).replace("_", "").toLowerCase();
+        }
+
+        @Override
+        public void close() throws IOException {
+            reader.close();
+        }
+    }
+}
@@ -0,0 +1,224 @@
+package com.blacklist.grpc;
+
+import com.blacklist.config.PsiConfig;
+import com.google.protobuf.CodedInputStream;
+import com.google.protobuf.CodedOutputStream;
+import lombok.extern.slf4j.Slf4j;
+import org.springframework.beans.factory.annotation.Autowired;
+import org.springframework.stereotype.Component;
+import psi.Psi;
+
+import java.io.BufferedOutputStream;
+import java.io.IOException;
+import java.io.OutputStream;
+import java.nio.ByteBuffer;
+import java.nio.MappedByteBuffer;
+import java.nio.channels.FileChannel;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.DirectoryStream;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.Paths;
+import java.nio.file.StandardCopyOption;
+import java.nio.file.StandardOpenOption;
+
+/**
+ * srv_data磁盘快照
+ *
+ * 文件格式（大端）：
+ *   magic    4字节  "PSIS"
+ *   format   4字节  格式版本号
+ *   length   4字节  版本号长度
+ *   version  UTF-8  黑名单版本号
+ *   body     只含srv_data的MatchRequest序列化结果
+ *
+ * 加载时通过mmap映射文件，由protobuf直接从映射区解析，不再经过堆上的整文件拷贝。
+ */
+@Slf4j
+@Component
+public class SrvDataSnapshotStore {
+
+    private static final int MAGIC = 0x50534953;  // "PSIS"
+    private static final int FORMAT_VERSION = 2;  // 2: 单label紧凑编码
+    private static final String FILE_PREFIX = "srvdata-";
+    private static final String FILE_SUFFIX = ".bin";
+
+    @Autowired
+    private PsiConfig psiConfig;
+
+    public boolean isEnabled() {
+        return psiConfig.getSnapshotDir() != null && !psiConfig.getSnapshotDir().isEmpty();
+    }
+
+    /**
+     * 读取指定版本的快照，不存在或格式不符时返回null
+     */
+    public Psi.MatchRequest load(String version) {
+        if (!isEnabled()) {
+            return null;
+        }
+
+        Path file = snapshotFile(version);
+        if (!Files.isRegularFile(file)) {
+            return null;
+        }
+
+        long startTime = System.currentTimeMillis();
+        try (FileChannel channel = FileChannel.open(file, StandardOpenOption.READ)) {
+            long size = channel.size();
+            if (size > Integer.MAX_VALUE) {
+                log.warn("srv_data快照超过2GB，无法映射: {}", file);
+                return null;
+            }
+
+            MappedByteBuffer buffer = channel.map(FileChannel.MapMode.READ_ONLY, 0, size);
+            if (buffer.getInt() != MAGIC || buffer.getInt() != FORMAT_VERSION) {
+                log.warn("srv_data快照格式不匹配，忽略: {}", file);
+                return null;
+            }
+
+            String fileVersion = readVersion(buffer);
+            if (!version.equals(fileVersion)) {
+                log.warn("srv_data快照版本不匹配，期望: {}, 实际: {}", version, fileVersion);
+                return null;
+            }
+
+            CodedInputStream input = CodedInputStream.newInstance(buffer);
+            input.setSizeLimit(Integer.MAX_VALUE);
+            Psi.MatchRequest template = Psi.MatchRequest.parseFrom(input);
+
+            log.info("已加载srv_data快照: {}, 数据量: {}, 大小: {} 字节, 耗时: {}ms",
+                    file, template.getSrvDataCount(), size, System.currentTimeMillis() - startTime);
+            return template;
+
+        } catch (IOException | RuntimeException e) {
+            log.warn("加载srv_data快照失败: {}", file, e);
+            return null;
+        }
+    }
+
+    /**
+     * 写入快照（先写临时文件再原子替换），并清理其他版本的旧快照
+     */
+    public void save(String version, Psi.MatchRequest template) {
+        Path tmp = writeTemp(version, template);
+        if (tmp != null) {
+            commit(version, tmp);
+        }
+    }
+
+    /**
+     * 将快照写入临时文件，失败时返回null
+     * 与commit分开，便于调用方在提交前确认快照仍是最新的
+     */
+    public Path writeTemp(String version, Psi.MatchRequest template) {
+        if (!isEnabled()) {
+            return null;
+        }
+
+        long startTime = System.currentTimeMillis();
+        Path dir = Paths.get(psiConfig.getSnapshotDir());
+        Path tmp = null;
+
+        try {
+            Files.createDirectories(dir);
+            tmp = Files.createTempFile(dir, FILE_PREFIX + version + "-", ".tmp");
+
+            try (OutputStream out = new BufferedOutputStream(Files.newOutputStream(tmp), 1 << 20)) {
+                CodedOutputStream coded = CodedOutputStream.newInstance(out, 1 << 16);
+                coded.writeFixed32NoTag(Integer.reverseBytes(MAGIC));
+                coded.writeFixed32NoTag(Integer.reverseBytes(FORMAT_VERSION));
+                writeVersion(coded, version);
+                template.writeTo(coded);
+                coded.flush();
+            }
+
+            log.info("srv_data快照临时文件写入完成: {}, 耗时: {}ms", tmp, System.currentTimeMillis() - startTime);
+            return tmp;
+        } catch (IOException | RuntimeException e) {
+            log.warn("写入srv_data快照失败: {}", tmp, e);
+            discard(tmp);
+            return null;
+        }
+    }
+
+    /**
+     * 原子替换为正式快照，并清理其他版本的旧快照
+     */
+    public void commit(String version, Path tmp) {
+        Path file = snapshotFile(version);
+        try {
+            Files.move(tmp, file, StandardCopyOption.REPLACE_EXISTING, StandardCopyOption.ATOMIC_MOVE);
+            log.info("已写入srv_data快照: {}", file);
+
+            deleteOthers(version);
+        } catch (IOException | RuntimeException e) {
+            log.warn("提交srv_data快照失败: {}", file, e);
+            discard(tmp);
+        }
+    }
+
+    /**
+     * 丢弃未提交的临时文件
+     */
+    public void discard(Path tmp) {
+        if (tmp == null) {
+            return;
+        }
+        try {
+            Files.deleteIfExists(tmp);
+        } catch (IOException ignored) {
+            // 临时文件清理失败不影响查询
+        }
+    }
+
+    /**
+     * 删除全部快照（黑名单重建时调用）
+     */
+    public void clear() {
+        deleteOthers(null);
+    }
+
+    private void deleteOthers(String keepVersion) {
+        if (!isEnabled()) {
+            return;
+        }
+
+        Path dir = Paths.get(psiConfig.getSnapshotDir());
+        if (!Files.isDirectory(dir)) {
+            return;
+        }
+
+        Path keep = keepVersion != null ? snapshotFile(keepVersion).getFileName() : null;
+        try (DirectoryStream<Path> files = Files.newDirectoryStream(dir, FILE_PREFIX + "*" + FILE_SUFFIX)) {
+            for (Path f : files) {
+                if (!f.getFileName().equals(keep)) {
+                    Files.deleteIfExists(f);
+                    log.info("已删除旧srv_data快照: {}", f);
+                }
+            }
+        } catch (IOException e) {
+            log.warn("清理srv_data快照失败: {}", dir, e);
+        }
+    }
+
+    private Path snapshotFile(String version) {
+        return Paths.get(psiConfig.getSnapshotDir(), FILE_PREFIX + version + FILE_SUFFIX);
+    }
+
+    private static void writeVersion(CodedOutputStream coded, String version) throws IOException {
+        byte[] bytes = version.getBytes(StandardCharsets.UTF_8);
+        coded.writeFixed32NoTag(Integer.reverseBytes(bytes.length));
+        coded.writeRawBytes(bytes);
+    }
+
+    private static String readVersion(ByteBuffer buffer) throws IOException {
+        int length = buffer.getInt();
+        if (length < 0 || length > buffer.remaining()) {
+            throw new IOException("快照版本号长度非法: " + length);
+        }
+        byte[] bytes = new byte[length];
+        buffer.get(bytes);
+        return new String(bytes, StandardCharsets.UTF_8);
+    }
+}
@@ -1,7 +1,12 @@
 package com.blacklist.service;
 
+import com.blacklist.dto.BlacklistEntryParam;
+import com.blacklist.dto.BlacklistIngestDTO;
+import com.blacklist.dto.BlacklistIngestParam;
 import com.blacklist.dto.BlacklistStatusDTO;
 
+import java.util.List;
+
 /**
  * 黑名单Service接口
  */
@@ -24,4 +29,30 @@ public interface BlacklistService {
      * @return 黑名单总数
      */
     Long getCount();  // 🔥 新增方法
+
+    /**
+     * 获取黑名单版本号（用于srv_data缓存）
+     * @return 版本号
+     */
+    String getVersion();
+
+    /**
+     * 新增或更新黑名单条目（按身份证号），只增量更新srv_data缓存
+     * @param entries 条目列表
+     */
+    void upsertEntries(List<BlacklistEntryParam> entries);
+
+    /**
+     * 删除黑名单条目，只增量更新srv_data缓存
+     * @param idCards 身份证号列表
+     * @return 实际删除的条数
+     */
+    int removeEntries(List<String> idCards);
+
+    /**
+     * 从blacklist_main/behavior_record导出文件批量导入黑名单，写入数据库并构建srv_data缓存和快照
+     * @param param 导出文件路径
+     * @return 导入结果
+     */
+    BlacklistIngestDTO ingestDump(BlacklistIngestParam param);
 }
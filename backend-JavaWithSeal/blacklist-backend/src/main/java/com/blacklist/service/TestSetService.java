@@ -24,9 +24,11 @@ public interface TestSetService {
     void saveEncryptedData(String payloadData, String contextData);
     /**
      * 查询黑名单
+     * @param contextData   Base64编码的上下文，为空时按contextDigest取后端缓存
+     * @param contextDigest 上下文SHA256摘要
      * @return 查询结果
      */
-    QueryResultDTO queryBlacklist(String payloadData, String contextData);
+    QueryResultDTO queryBlacklist(String payloadData, String contextData, String contextDigest);
 
 
         /**
@@ -1,24 +1,44 @@
 package com.blacklist.service.impl;
 
+import com.baomidou.mybatisplus.core.conditions.query.LambdaQueryWrapper;
 import com.baomidou.mybatisplus.core.conditions.query.QueryWrapper;
 import com.blacklist.common.BusinessException;
+import com.blacklist.dto.BehaviorRecordParam;
+import com.blacklist.dto.BlacklistEntryParam;
+import com.blacklist.dto.BlacklistFullInfo;
+import com.blacklist.dto.BlacklistIngestDTO;
+import com.blacklist.dto.BlacklistIngestParam;
 import com.blacklist.dto.BlacklistStatusDTO;
 import com.blacklist.entity.BehaviorRecord;
 import com.blacklist.entity.BlacklistMain;
 import com.blacklist.enums.BehaviorLevelEnum;
 import com.blacklist.enums.BehaviorTypeEnum;
+import com.blacklist.enums.ToolTypeEnum;
+import com.blacklist.grpc.PSIGrpcClient;
+import com.blacklist.grpc.SrvDataCache;
+import com.blacklist.grpc.SrvDataIngestor;
 import com.blacklist.mapper.BehaviorRecordMapper;
 import com.blacklist.mapper.BlacklistMainMapper;
 import com.blacklist.service.BlacklistService;
 import com.blacklist.util.BehaviorGenerator;
 import com.blacklist.util.IdCardGenerator;
+import com.blacklist.util.IdCardHashUtil;
 import lombok.extern.slf4j.Slf4j;
 import org.springframework.beans.factory.annotation.Autowired;
 import org.springframework.stereotype.Service;
 import org.springframework.transaction.annotation.Transactional;
+import org.springframework.transaction.support.TransactionSynchronization;
+import org.springframework.transaction.support.TransactionSynchronizationManager;
+import psi.Psi;
 
+import java.io.IOException;
+import java.nio.file.Files;
+import java.nio.file.Path;
+import java.nio.file.Paths;
 import java.util.ArrayList;
+import java.util.HashMap;
 import java.util.List;
+import java.util.Map;
 import java.util.Random;
 import java.util.Set;
 
@@ -35,6 +55,12 @@ public class BlacklistServiceImpl implements BlacklistService {
     @Autowired
     private BehaviorRecordMapper behaviorRecordMapper;
 
+    @Autowired
+    private SrvDataCache srvDataCache;
+
+    @Autowired
+    private SrvDataIngestor srvDataIngestor;
+
     /**
      * 创建黑名单
      * @param size 黑名单规模
@@ -49,9 +75,10 @@ public class BlacklistServiceImpl implements BlacklistService {
         try {
             log.info("开始创建黑名单，规模: {}", size);
 
-            // 清空原有数据
+            // 清空原有数据，缓存在事务提交后才失效，回滚时保留原缓存
             blacklistMainMapper.delete(null);
             behaviorRecordMapper.delete(null);
+            invalidateCacheAfterCommit();
             log.info("已清空原有黑名单数据");
 
             // 批量插入（分批处理，每批1000条）
@@ -108,6 +135,20 @@ public class BlacklistServiceImpl implements BlacklistService {
         }
     }
 
+    /**
+     * 事务提交后使srv_data缓存失效
+     *
+     * 提交前失效的话，并发查询会按尚未提交的旧数据重建缓存并写入快照，回滚时缓存也已丢失。
+     */
+    private void invalidateCacheAfterCommit() {
+        TransactionSynchronizationManager.registerSynchronization(new TransactionSynchronization() {
+            @Override
+            public void afterCommit() {
+                srvDataCache.invalidate();
+            }
+        });
+    }
+
     /**
      * 生成随机记录数（1-3）
      */
@@ -145,4 +186,238 @@ public class BlacklistServiceImpl implements BlacklistService {
         log.debug("查询黑名单数量: {}", count);
         return count != null ? count : 0L;
     }
+
+    /**
+     * 获取黑名单版本号：总数 + 最大user_id
+     * 黑名单重建会清空并重新自增插入，两者之一必然变化；
+     * 单条更新不改变版本号时由applyUpdates直接修改缓存内容
+     */
+    @Override
+    public String getVersion() {
+        List<Map<String, Object>> rows = blacklistMainMapper.selectMaps(
+                new QueryWrapper<BlacklistMain>().select("COUNT(*) AS total", "MAX(user_id) AS maxId")
+        );
+        Map<String, Object> row = rows.isEmpty() ? null : rows.get(0);
+        Object total = row != null ? row.get("total") : null;
+        Object maxId = row != null ? row.get("maxId") : null;
+        return (total != null ? total : 0) + "-" + (maxId != null ? maxId : 0);
+    }
+
+    /**
+     * 新增或更新黑名单条目
+     */
+    @Override
+    @Transactional(rollbackFor = Exception.class)
+    public void upsertEntries(List<BlacklistEntryParam> entries) {
+        if (entries == null || entries.isEmpty()) {
+            throw new BusinessException(400, "黑名单条目不能为空");
+        }
+
+        CacheDelta delta = new CacheDelta();
+        for (BlacklistEntryParam entry : entries) {
+            BlacklistFullInfo info = saveEntry(entry);
+            delta.puts.put(IdCardHashUtil.hashIdCard(entry.getIdCard()), PSIGrpcClient.encodeLabels(info));
+        }
+        delta.newVersion = getVersion();
+
+        log.info("黑名单增量更新完成，条数: {}", entries.size());
+    }
+
+    /**
+     * 删除黑名单条目
+     */
+    @Override
+    @Transactional(rollbackFor = Exception.class)
+    public int removeEntries(List<String> idCards) {
+        if (idCards == null || idCards.isEmpty()) {
+            throw new BusinessException(400, "身份证号列表不能为空");
+        }
+
+        CacheDelta delta = new CacheDelta();
+        for (String idCard : idCards) {
+            BlacklistMain main = blacklistMainMapper.selectOne(
+                    new LambdaQueryWrapper<BlacklistMain>().eq(BlacklistMain::getIdCard, idCard));
+            if (main == null) {
+                log.warn("黑名单中不存在身份证号: {}", idCard);
+                continue;
+            }
+
+            behaviorRecordMapper.delete(
+                    new LambdaQueryWrapper<BehaviorRecord>().eq(BehaviorRecord::getUserId, main.getUserId()));
+            blacklistMainMapper.deleteById(main.getUserId());
+            delta.removes.add(IdCardHashUtil.hashIdCard(idCard));
+        }
+        delta.newVersion = getVersion();
+
+        log.info("黑名单增量删除完成，条数: {}", delta.removes.size());
+        return delta.removes.size();
+    }
+
+    /**
+     * 一次增删改对srv_data缓存的增量
+     *
+     * 在事务内收集，事务提交后才写入缓存，回滚时丢弃，缓存不会看到未提交的数据。
+     * 数据库读写期间不持有缓存的锁，查询不会被增删改阻塞。
+     */
+    private class CacheDelta implements TransactionSynchronization {
+        final String oldVersion = getVersion();
+        String newVersion;
+        final Map<Long, Psi.LabelsType> puts = new HashMap<>();
+        final List<Long> removes = new ArrayList<>();
+
+        CacheDelta() {
+            TransactionSynchronizationManager.registerSynchronization(this);
+            srvDataCache.beginUpdate();
+        }
+
+        @Override
+        public void afterCommit() {
+            srvDataCache.applyUpdates(oldVersion, newVersion, puts, removes);
+        }
+
+        @Override
+        public void afterCompletion(int status) {
+            srvDataCache.endUpdate();
+        }
+    }
+
+    /**
+     * 校验并写入单条黑名单（已存在则替换评级与行为记录）
+     */
+    private BlacklistFullInfo saveEntry(BlacklistEntryParam entry) {
+        if (entry.getIdCard() == null || entry.getIdCard().isEmpty()) {
+            throw new BusinessException(400, "身份证号不能为空");
+        }
+        BehaviorLevelEnum riskLevel = BehaviorLevelEnum.getByCode(entry.getRiskLevel());
+        if (riskLevel == null) {
+            throw new BusinessException(400, "行为评级无效: " + entry.getRiskLevel());
+        }
+        if (entry.getRecords() == null || entry.getRecords().isEmpty() || entry.getRecords().size() > 3) {
+            throw new BusinessException(400, "行为记录数必须在1-3之间: " + entry.getIdCard());
+        }
+
+        BlacklistMain main = blacklistMainMapper.selectOne(
+                new LambdaQueryWrapper<BlacklistMain>().eq(BlacklistMain::getIdCard, entry.getIdCard()));
+        boolean exists = main != null;
+        if (!exists) {
+            main = new BlacklistMain();
+            main.setIdCard(entry.getIdCard());
+        }
+        main.setRiskLevel(riskLevel);
+        main.setRecordCount(entry.getRecords().size());
+
+        if (exists) {
+            blacklistMainMapper.updateById(main);
+            behaviorRecordMapper.delete(
+                    new LambdaQueryWrapper<BehaviorRecord>().eq(BehaviorRecord::getUserId, main.getUserId()));
+        } else {
+            blacklistMainMapper.insert(main);
+        }
+
+        List<BehaviorRecord> records = new ArrayList<>();
+        for (BehaviorRecordParam param : entry.getRecords()) {
+            BehaviorTypeEnum behaviorType = BehaviorTypeEnum.getByCode(param.getBehaviorType());
+            ToolTypeEnum tool = ToolTypeEnum.getByCode(param.getTool());
+            if (behaviorType == null || tool == null) {
+                throw new BusinessException(400, "行为记录无效: " + entry.getIdCard());
+            }
+
+            BehaviorRecord record = new BehaviorRecord();
+            record.setUserId(main.getUserId());
+            record.setBehaviorType(behaviorType);
+            record.setTool(tool);
+            records.add(record);
+        }
+        behaviorRecordMapper.insert(records);
+
+        BlacklistFullInfo info = new BlacklistFullInfo();
+        info.setMain(main);
+        info.setRecords(records);
+        return info;
+    }
+
+    /**
+     * 批量导入黑名单导出文件
+     *
+     * 导入替换整个黑名单：导出数据与srv_data在同一操作中写入，
+     * 缓存按写库后的数据库版本安装，事务提交后才生效。
+     */
+    @Override
+    @Transactional(rollbackFor = Exception.class)
+    public BlacklistIngestDTO ingestDump(BlacklistIngestParam param) {
+        if (param == null || param.getMainFile() == null || param.getMainFile().isEmpty()
+                || param.getRecordFile() == null || param.getRecordFile().isEmpty()) {
+            throw new BusinessException(400, "导出文件路径不能为空");
+        }
+        Path mainFile = Paths.get(param.getMainFile());
+        Path recordFile = Paths.get(param.getRecordFile());
+        if (!Files.isRegularFile(mainFile) || !Files.isRegularFile(recordFile)) {
+            throw new BusinessException(400, "导出文件不存在");
+        }
+
+        char delimiter;
+        if (param.getDelimiter() != null && !param.getDelimiter().isEmpty()) {
+            delimiter = "\\t".equals(param.getDelimiter()) ? '\t' : param.getDelimiter().charAt(0);
+        } else {
+            delimiter = mainFile.getFileName().toString().toLowerCase().endsWith(".tsv") ? '\t' : ',';
+        }
+
+        log.info("开始批量导入黑名单导出文件: {}, {}", mainFile, recordFile);
+        long startTime = System.currentTimeMillis();
+
+        // 缓存在事务提交后由install整体替换，回滚时保留原缓存
+        blacklistMainMapper.delete(null);
+        behaviorRecordMapper.delete(null);
+        log.info("已清空原有黑名单数据");
+
+        SrvDataIngestor.Ingested ingested;
+        try {
+            ingested = srvDataIngestor.ingest(mainFile, recordFile, delimiter, this::insertBatch);
+        } catch (IllegalArgumentException e) {
+            throw new BusinessException(400, "导出文件格式错误: " + e.getMessage());
+        } catch (IOException | RuntimeException e) {
+            log.error("批量导入失败", e);
+            throw new BusinessException("批量导入失败: " + e.getMessage());
+        }
+
+        String version = getVersion();
+        Map<Long, Psi.LabelsType> srvData = ingested.getSrvData();
+        TransactionSynchronizationManager.registerSynchronization(new TransactionSynchronization() {
+            @Override
+            public void afterCommit() {
+                srvDataCache.install(version, srvData);
+            }
+        });
+        log.info("黑名单导入完成，主表: {} 条，版本: {}", ingested.getMainCount(), version);
+
+        BlacklistIngestDTO result = new BlacklistIngestDTO();
+        result.setVersion(version);
+        result.setSrvDataCount(srvData.size());
+        result.setRecordCount(ingested.getRecordCount());
+        result.setElapsedMillis(System.currentTimeMillis() - startTime);
+        return result;
+    }
+
+    /**
+     * 写入导出文件的一个批次，user_id由数据库重新分配，行为记录随之改写
+     */
+    private void insertBatch(List<BlacklistFullInfo> batch) {
+        List<BlacklistMain> mainList = new ArrayList<>(batch.size());
+        for (BlacklistFullInfo info : batch) {
+            info.getMain().setUserId(null);
+            mainList.add(info.getMain());
+        }
+        blacklistMainMapper.insert(mainList);
+
+        List<BehaviorRecord> recordList = new ArrayList<>();
+        for (BlacklistFullInfo info : batch) {
+            for (BehaviorRecord record : info.getRecords()) {
+                record.setUserId(info.getMain().getUserId());
+                recordList.add(record);
+            }
+        }
+        if (!recordList.isEmpty()) {
+            behaviorRecordMapper.insert(recordList);
+        }
+    }
 }
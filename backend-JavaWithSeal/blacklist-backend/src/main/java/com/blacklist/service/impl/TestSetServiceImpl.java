@@ -7,16 +7,22 @@ import com.blacklist.dto.BlacklistFullInfo;
 import com.blacklist.dto.QueryResultDTO;
 import com.blacklist.entity.BehaviorRecord;
 import com.blacklist.entity.BlacklistMain;
+import com.blacklist.grpc.ContextCache;
 import com.blacklist.grpc.PSIGrpcClient;
+import com.blacklist.grpc.PsiMetrics;
+import com.blacklist.grpc.SrvDataCache;
 import com.blacklist.mapper.BehaviorRecordMapper;
 import com.blacklist.mapper.BlacklistMainMapper;
+import com.blacklist.service.BlacklistService;
 import com.blacklist.service.TestSetService;
 import com.blacklist.util.IdCardGenerator;
+import com.google.protobuf.ByteString;
 import lombok.extern.slf4j.Slf4j;
 import org.apache.poi.ss.usermodel.*;
 import org.springframework.beans.factory.annotation.Autowired;
 import org.springframework.stereotype.Service;
 import org.springframework.transaction.annotation.Transactional;
+import psi.Psi;
 
 import java.util.*;
 import java.util.stream.Collectors;
@@ -37,6 +43,18 @@ public class TestSetServiceImpl implements TestSetService {
     @Autowired
     private PSIGrpcClient psiGrpcClient;
 
+    @Autowired
+    private SrvDataCache srvDataCache;
+
+    @Autowired
+    private BlacklistService blacklistService;
+
+    @Autowired
+    private ContextCache contextCache;
+
+    @Autowired
+    private PsiMetrics psiMetrics;
+
     /**
      * 创建测试集
      */
@@ -120,38 +138,57 @@ public class TestSetServiceImpl implements TestSetService {
     }
 
     @Override
-    public QueryResultDTO queryBlacklist(String payloadData, String contextData) {
+    public QueryResultDTO queryBlacklist(String payloadData, String contextData, String contextDigest) {
         log.info("开始执行黑名单查询");
         long startTime = System.currentTimeMillis();
+        long startNanos = System.nanoTime();
+        boolean success = false;
+        psiMetrics.queryStarted();
 
         try {
-            // 1. 从数据库查询黑名单完整数据（主表 + 行为记录）
-            log.info("查询黑名单完整数据...");
-            List<BlacklistFullInfo> blacklistFullData = queryAllBlacklistWithRecords();
-
-            if (blacklistFullData.isEmpty()) {
+            // 0. 解析上下文（客户端已上传过时只发送摘要）
+            long phaseStart = System.nanoTime();
+            ByteString context = resolveContext(contextData, contextDigest);
+            psiMetrics.record("context", phaseStart);
+
+            // 1. 获取已编码的srv_data（黑名单版本未变化时直接复用缓存）
+            phaseStart = System.nanoTime();
+            String version = blacklistService.getVersion();
+            log.info("当前黑名单版本: {}", version);
+            Psi.MatchRequest srvTemplate = srvDataCache.getOrLoad(version, () -> {
+                List<BlacklistFullInfo> blacklistFullData = queryAllBlacklistWithRecords();
+                log.info("黑名单数据量: {}", blacklistFullData.size());
+                return psiGrpcClient.convertBlacklistToSrvData(blacklistFullData);
+            });
+            psiMetrics.record("srv_data", phaseStart);
+
+            if (srvTemplate.getSrvDataCount() == 0) {
+                srvDataCache.invalidate();
                 throw new BusinessException(400, "黑名单库为空");
             }
 
-            log.info("黑名单数据量: {}", blacklistFullData.size());
-
-            // 2. 调用gRPC进行PSI匹配（传递完整数据）
+            // 2. 调用gRPC进行PSI匹配
             log.info("调用gRPC进行PSI匹配...");
-            String encryptedResult = psiGrpcClient.doMatch(contextData, payloadData, blacklistFullData);
+            List<String> encryptedResults = psiGrpcClient.doMatch(context, payloadData, srvTemplate);
 
             // 3. 解析匹配数量（需要根据C++服务器返回的格式来解析）
             // 暂时返回0，后续需要实现解析逻辑
-            int matchCount = parseMatchCount(encryptedResult);
+            int matchCount = parseMatchCount(encryptedResults);
 
             long endTime = System.currentTimeMillis();
             log.info("查询完成，耗时: {}ms, 匹配数: {}", endTime - startTime, matchCount);
 
             // 4. 构建返回结果
             QueryResultDTO result = new QueryResultDTO();
-            result.setEncryptedResult(encryptedResult);  // 返回给Qt用于解密
+            if (encryptedResults.size() == 1) {
+                result.setEncryptedResult(encryptedResults.get(0));  // 返回给Qt用于解密
+            } else {
+                result.setEncryptedResults(encryptedResults);  // 分片模式，Qt逐个解密后合并
+            }
             result.setMatchCount(matchCount);
-            result.setTotalCount(blacklistFullData.size());
+            result.setTotalCount(srvTemplate.getSrvDataCount());
 
+            success = true;
             return result;
 
         } catch (BusinessException e) {
@@ -159,7 +196,33 @@ public class TestSetServiceImpl implements TestSetService {
         } catch (Exception e) {
             log.error("查询失败", e);
             throw new BusinessException("查询失败: " + e.getMessage());
+        } finally {
+            psiMetrics.record("total", startNanos);
+            psiMetrics.queryFinished(success);
+        }
+    }
+
+    /**
+     * 获取本次查询的上下文
+     * 携带contextData时解码并写入缓存；只携带摘要时从缓存读取，未命中返回409，由客户端重新上传
+     */
+    private ByteString resolveContext(String contextData, String contextDigest) {
+        if (contextData != null && !contextData.isEmpty()) {
+            ByteString context = ByteString.copyFrom(Base64.getDecoder().decode(contextData));
+            String digest = contextCache.put(context);
+            if (contextDigest != null && !contextDigest.isEmpty() && !contextDigest.equalsIgnoreCase(digest)) {
+                log.warn("上下文摘要不一致，客户端: {}, 实际: {}", contextDigest, digest);
+            }
+            log.info("上下文已缓存，摘要: {}", digest);
+            return context;
+        }
+
+        ByteString context = contextCache.get(contextDigest);
+        if (context == null) {
+            throw new BusinessException(409, "上下文未缓存，请重新上传: " + contextDigest);
         }
+        log.info("命中上下文缓存，摘要: {}", contextDigest);
+        return context;
     }
 
     /**
@@ -208,7 +271,7 @@ public class TestSetServiceImpl implements TestSetService {
     /**
      * 解析匹配数量（暂时返回0，后续根据C++返回格式实现）
      */
-    private int parseMatchCount(String encryptedResult) {
+    private int parseMatchCount(List<String> encryptedResults) {
         // TODO: 根据C++服务器返回的加密结果格式，解析出匹配数量
         // 这里需要和C++同事确认返回格式
         return 0;
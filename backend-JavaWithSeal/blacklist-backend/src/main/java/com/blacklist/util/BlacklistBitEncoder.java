@@ -8,68 +8,102 @@ import lombok.extern.slf4j.Slf4j;
 import java.util.List;
 
 /**
- * 黑名单信息位编码工具（多labels方案）
+ * 黑名单信息位编码工具（单label紧凑方案）
  *
- * 编码格式：
- * labels[0]: [3-0]位=行为评级, [7-4]位=行为记录数
- * labels[1]: [3-0]位=记录1行为类型, [7-4]位=记录1使用工具
- * labels[2]: [3-0]位=记录2行为类型, [7-4]位=记录2使用工具
- * labels[3]: [3-0]位=记录3行为类型, [7-4]位=记录3使用工具
+ * 所有字段打包进一个label，每个字段2位，共16位：
+ * [1-0]位=行为评级, [3-2]位=行为记录数,
+ * [5-4]位=记录1行为类型, [7-6]位=记录1使用工具,
+ * [9-8]位=记录2行为类型, [11-10]位=记录2使用工具,
+ * [13-12]位=记录3行为类型, [15-14]位=记录3使用工具
+ *
+ * 每条黑名单只占一个label，psisrv的labels列数和返回的结果密文数都只有原多labels方案的1/4。
+ * 打包结果须小于BFV明文模数（PLAIN_MODULUS_BITS位素数，与Qt端BlacklistLabelCodec::kPlainModulusBits一致），
+ * 否则解密后取模会丢失高位，类加载时检查TOTAL_BITS。
+ * 位布局与Qt端blacklistlabelcodec.h一致，修改时两端需同步。
  */
 @Slf4j
 public class BlacklistBitEncoder {
 
+    public static final int FIELD_BITS = 2;
+    public static final int FIELD_MASK = (1 << FIELD_BITS) - 1;
+    public static final int MAX_RECORDS = 3;
+
+    private static final int RISK_SHIFT = 0;
+    private static final int COUNT_SHIFT = 2;
+    private static final int RECORD_SHIFT = 4;
+    private static final int RECORD_BITS = 2 * FIELD_BITS;
+    public static final int TOTAL_BITS = RECORD_SHIFT + MAX_RECORDS * RECORD_BITS;
+
+    /**
+     * BFV明文模数位数，明文模数不小于2^(PLAIN_MODULUS_BITS-1)
+     */
+    public static final int PLAIN_MODULUS_BITS = 20;
+
+    static {
+        if (TOTAL_BITS >= PLAIN_MODULUS_BITS) {
+            throw new IllegalStateException("打包label位数" + TOTAL_BITS + "须小于明文模数位数" + PLAIN_MODULUS_BITS);
+        }
+    }
+
     /**
      * 将黑名单完整信息编码为labels数组
-     * @return long数组，每个元素对应一个label
+     * @return 只含一个打包label的long数组
      */
     public static long[] encodeBlacklistInfoToLabels(BlacklistFullInfo info) {
+        return new long[]{pack(info)};
+    }
+
+    /**
+     * 将黑名单完整信息打包为单个label
+     */
+    public static long pack(BlacklistFullInfo info) {
         BlacklistMain main = info.getMain();
         List<BehaviorRecord> records = info.getRecords();
+        if (records.size() > MAX_RECORDS) {
+            throw new IllegalArgumentException("行为记录数超过" + MAX_RECORDS + ": " + records.size());
+        }
 
-        // labels数组长度 = 1(基本信息) + 实际记录数
-        int labelsCount = 1 + records.size();
-        long[] labels = new long[labelsCount];
-
-        // labels[0]: 行为评级(低4位) + 行为记录数(高4位)
-        long riskLevel = main.getRiskLevel().getCode().longValue();
-        long recordCount = main.getRecordCount().longValue();
-        labels[0] = (riskLevel & 0xF) | ((recordCount & 0xF) << 4);
+        long label = field(main.getRiskLevel().getCode(), "行为评级") << RISK_SHIFT
+                | field(main.getRecordCount(), "行为记录数") << COUNT_SHIFT;
 
-        // labels[1-3]: 每条行为记录
         for (int i = 0; i < records.size(); i++) {
             BehaviorRecord record = records.get(i);
-            long behaviorType = record.getBehaviorType().getCode().longValue();
-            long toolType = record.getTool().getCode().longValue();
-
-            // 行为类型(低4位) + 使用工具(高4位)
-            labels[i + 1] = (behaviorType & 0xF) | ((toolType & 0xF) << 4);
+            int shift = RECORD_SHIFT + i * RECORD_BITS;
+            label |= field(record.getBehaviorType().getCode(), "行为类型") << shift;
+            label |= field(record.getTool().getCode(), "使用工具") << (shift + FIELD_BITS);
         }
+        return label;
+    }
 
-        return labels;
+    private static long field(Integer value, String name) {
+        if (value == null || value < 0 || value > FIELD_MASK) {
+            throw new IllegalArgumentException(name + "超出2位编码范围: " + value);
+        }
+        return value;
     }
 
     /**
-     * 解码labels[0]获取行为评级
+     * 解码获取行为评级
      */
-    public static int decodeRiskLevel(long label0) {
-        return (int) (label0 & 0xF);
+    public static int decodeRiskLevel(long label) {
+        return (int) ((label >>> RISK_SHIFT) & FIELD_MASK);
     }
 
     /**
-     * 解码labels[0]获取行为记录数
+     * 解码获取行为记录数
      */
-    public static int decodeRecordCount(long label0) {
-        return (int) ((label0 >> 4) & 0xF);
+    public static int decodeRecordCount(long label) {
+        return (int) ((label >>> COUNT_SHIFT) & FIELD_MASK);
     }
 
     /**
-     * 解码行为记录label（labels[1-3]）
+     * 解码第index条行为记录（从0开始）
      * @return [行为类型, 使用工具]
      */
-    public static int[] decodeBehaviorLabel(long label) {
-        int behaviorType = (int) (label & 0xF);
-        int toolType = (int) ((label >> 4) & 0xF);
+    public static int[] decodeBehavior(long label, int index) {
+        int shift = RECORD_SHIFT + index * RECORD_BITS;
+        int behaviorType = (int) ((label >>> shift) & FIELD_MASK);
+        int toolType = (int) ((label >>> (shift + FIELD_BITS)) & FIELD_MASK);
         return new int[]{behaviorType, toolType};
     }
 
@@ -80,19 +114,17 @@ public class BlacklistBitEncoder {
         log.info("=== Labels编码信息 ===");
         log.info("labels.length: {}", labels.length);
 
-        if (labels.length > 0) {
-            log.info("labels[0]: {} (评级={}, 记录数={})",
-                    labels[0],
-                    decodeRiskLevel(labels[0]),
-                    decodeRecordCount(labels[0]));
-        }
-
-        for (int i = 1; i < labels.length; i++) {
-            int[] decoded = decodeBehaviorLabel(labels[i]);
-            log.info("labels[{}]: {} (行为类型={}, 使用工具={})",
-                    i, labels[i], decoded[0], decoded[1]);
+        for (int i = 0; i < labels.length; i++) {
+            long label = labels[i];
+            int recordCount = decodeRecordCount(label);
+            log.info("labels[{}]: {} (评级={}, 记录数={})",
+                    i, label, decodeRiskLevel(label), recordCount);
+            for (int j = 0; j < recordCount; j++) {
+                int[] decoded = decodeBehavior(label, j);
+                log.info("  记录{}: 行为类型={}, 使用工具={}", j + 1, decoded[0], decoded[1]);
+            }
         }
 
         log.info("====================");
     }
-}
\ No newline at end of file
+}
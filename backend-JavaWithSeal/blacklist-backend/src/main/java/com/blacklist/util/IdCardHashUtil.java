@@ -1,15 +1,39 @@
 package com.blacklist.util;
 
 import java.nio.charset.StandardCharsets;
+import java.security.DigestException;
 import java.security.MessageDigest;
 import java.security.NoSuchAlgorithmException;
 
 /**
  * 身份证号哈希工具类
  * 使用与Qt端相同的SHA256算法
+ *
+ * 18位身份证号直接写入按线程复用的字节缓冲，不经过String.getBytes和digest()的数组分配；
+ * SHA256压缩由JVM内建函数（UseSHA256Intrinsics）使用SHA-NI/AVX2执行。
  */
 public class IdCardHashUtil {
 
+    private static final int ID_CARD_LENGTH = 18;
+    private static final int SHA256_LENGTH = 32;
+
+    /**
+     * MessageDigest非线程安全，且getInstance需要查找Provider，按线程复用
+     */
+    private static final ThreadLocal<MessageDigest> SHA256 = ThreadLocal.withInitial(() -> {
+        try {
+            return MessageDigest.getInstance("SHA-256");
+        } catch (NoSuchAlgorithmException e) {
+            throw new RuntimeException("SHA-256算法不可用", e);
+        }
+    });
+
+    /**
+     * 按线程复用的输入/输出缓冲：[0,18)为身份证号，[18,50)为摘要
+     */
+    private static final ThreadLocal<byte[]> BUFFER =
+            ThreadLocal.withInitial(() -> new byte[ID_CARD_LENGTH + SHA256_LENGTH]);
+
     /**
      * 将身份证号转换为size_t(long)
      * 使用SHA256哈希，取前8字节
@@ -21,22 +45,49 @@ public class IdCardHashUtil {
             return 0L;
         }
 
-        try {
-            // 使用SHA256哈希
-            MessageDigest digest = MessageDigest.getInstance("SHA-256");
-            byte[] hash = digest.digest(idCard.getBytes(StandardCharsets.UTF_8));
-
-            // 取前8字节转换为long（size_t）
-            long result = 0L;
-            for (int i = 0; i < 8 && i < hash.length; i++) {
-                result = (result << 8) | (hash[i] & 0xFF);
+        if (idCard.length() == ID_CARD_LENGTH) {
+            byte[] buffer = BUFFER.get();
+            if (toAscii(idCard, buffer)) {
+                return hashFixed(SHA256.get(), buffer);
+            }
+        }
+
+        // 其他长度或含非ASCII字符：使用SHA256哈希
+        byte[] hash = SHA256.get().digest(idCard.getBytes(StandardCharsets.UTF_8));
+
+        // 取前8字节转换为long（size_t）
+        long result = 0L;
+        for (int i = 0; i < 8 && i < hash.length; i++) {
+            result = (result << 8) | (hash[i] & 0xFF);
+        }
+
+        return result;
+    }
+
+    private static boolean toAscii(String idCard, byte[] buffer) {
+        for (int i = 0; i < ID_CARD_LENGTH; i++) {
+            char ch = idCard.charAt(i);
+            if (ch >= 0x80) {
+                return false;
             }
+            buffer[i] = (byte) ch;
+        }
+        return true;
+    }
 
-            return result;
+    private static long hashFixed(MessageDigest digest, byte[] buffer) {
+        try {
+            digest.update(buffer, 0, ID_CARD_LENGTH);
+            digest.digest(buffer, ID_CARD_LENGTH, SHA256_LENGTH);
+        } catch (DigestException e) {
+            throw new IllegalStateException("SHA-256计算失败", e);
+        }
 
-        } catch (NoSuchAlgorithmException e) {
-            throw new RuntimeException("SHA-256算法不可用", e);
+        long result = 0L;
+        for (int i = 0; i < 8; i++) {
+            result = (result << 8) | (buffer[ID_CARD_LENGTH + i] & 0xFF);
         }
+        return result;
     }
 
     /**
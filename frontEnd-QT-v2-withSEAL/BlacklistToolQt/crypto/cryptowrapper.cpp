@@ -9,32 +9,55 @@
 #include "psicommon.h"
 #include "psiclient.h"
 
+namespace {
+// 客户端上下文参数（weight, effective_lambda, log_poly_mod），目前libpsi只验证过这一组
+const size_t kWeight = 15;
+const size_t kEffectiveLambda = 16;
+const size_t kLogPolyMod = 14;
+
+// 批量哈希的分块大小，每块结束上报一次进度
+const int kHashChunk = 65536;
+
+// 身份证号为18位ASCII时写入out并返回true
+bool toFixedWidth(const QString& idCard, char* out)
+{
+    if (idCard.size() != static_cast<int>(IdCardHasher::kIdLength)) {
+        return false;
+    }
+    for (int i = 0; i < idCard.size(); ++i) {
+        const ushort ch = idCard.at(i).unicode();
+        if (ch >= 0x80) {
+            return false;
+        }
+        out[i] = static_cast<char>(ch);
+    }
+    return true;
+}
+}
+
+ClientContext::~ClientContext()
+{
+    PSI_Client_Context_Destory(handle);
+}
+
 CryptoWrapper::CryptoWrapper(QObject *parent)
     : QObject(parent)
-    , m_context(nullptr)
-    , m_revealTable(nullptr)
 {
 }
 
 CryptoWrapper::~CryptoWrapper()
 {
-    // 清理reveal_table
-    if (m_revealTable) {
-        PSI_Reveal_Table_Destory(m_revealTable);
-        m_revealTable = nullptr;
-    }
-
-    // 清理context
-    if (m_context) {
-        PSI_Client_Context_Destory(m_context);
-        m_context = nullptr;
-    }
+    // context和reveal_table由shared_ptr在最后一个RevealState释放后销毁
 }
 
 size_t CryptoWrapper::hashIdCard(const QString& idCard)
 {
-    // 将身份证号转换为size_t类型的key
-    // 使用SHA256哈希，取前8字节
+    char fixed[IdCardHasher::kIdLength];
+    if (toFixedWidth(idCard, fixed)) {
+        return static_cast<size_t>(IdCardHasher::hashOne(fixed));
+    }
+
+    // 其他长度：使用SHA256哈希，取前8字节
     QByteArray hash = QCryptographicHash::hash(
         idCard.toUtf8(),
         QCryptographicHash::Sha256
@@ -50,80 +73,88 @@ size_t CryptoWrapper::hashIdCard(const QString& idCard)
 
 bool CryptoWrapper::encryptIdCards(const QStringList& idCards,
                                    QString& contextOut,
-                                   QString& payloadOut)
+                                   QString& payloadOut,
+                                   RevealStatePtr* stateOut)
 {
     try {
         qDebug() << "开始加密，数据量：" << idCards.size();
 
-        // 清空之前的映射表
-        m_hashToIdCardMap.clear();
-
-        // 1. 将身份证号转换为size_t数组，并保存映射关系
-        std::vector<size_t> cli_data;
-        cli_data.reserve(idCards.size());
-
-        for (const QString& idCard : idCards) {
-            size_t key = hashIdCard(idCard);
-            cli_data.push_back(key);
-
-            // 保存映射关系：哈希值 → 身份证号
-            m_hashToIdCardMap[key] = idCard;
+        // 1. 批量计算身份证哈希，并建立哈希值 → 身份证号的映射
+        const int total = idCards.size();
+        emit encryptProgress(StageHashing, 0, total);
+
+        std::vector<uint64_t> keys(static_cast<size_t>(total));
+        std::vector<char> fixed(static_cast<size_t>(kHashChunk) * IdCardHasher::kIdLength);
+        for (int start = 0; start < total; start += kHashChunk) {
+            const int end = qMin(start + kHashChunk, total);
+
+            // 18位身份证号连续存放后批量哈希，其他格式逐个回退
+            QVector<int> irregular;
+            for (int i = start; i < end; ++i) {
+                if (!toFixedWidth(idCards[i], fixed.data() + (i - start) * IdCardHasher::kIdLength)) {
+                    irregular.append(i);
+                }
+            }
+            IdCardHasher::hashBatch(fixed.data(), static_cast<size_t>(end - start), keys.data() + start);
+            for (int i : irregular) {
+                keys[i] = hashIdCard(idCards[i]);
+            }
 
-            qDebug() << "身份证号:" << idCard << "-> 哈希值:" << key;
+            emit encryptProgress(StageHashing, end, total);
         }
 
-        qDebug() << "数据准备完成，实际数据量：" << cli_data.size();
-        qDebug() << "映射表大小：" << m_hashToIdCardMap.size();
+        auto state = std::make_shared<RevealState>();
+        state->idCards = idCards;
+        state->hashIndex.build(keys.data(), keys.size());
+        std::vector<size_t> cli_data(keys.begin(), keys.end());
 
-        // 2. 清理旧的上下文和reveal_table（如果存在）
-        if (m_revealTable) {
-            PSI_Reveal_Table_Destory(m_revealTable);
-            m_revealTable = nullptr;
+        for (int i = 0; i < total && i < 3; ++i) {
+            qDebug() << "身份证号:" << idCards[i] << "-> 哈希值:" << keys[i];
         }
+        qDebug() << "数据准备完成，实际数据量：" << cli_data.size()
+                 << "，哈希实现：" << IdCardHasher::implementationName();
+        qDebug() << "映射表大小：" << state->hashIndex.size();
+
+        // 2. 创建客户端上下文（参数：15, 16, 14）
+        // 上下文与测试集内容无关，只在首次加密时生成密钥并序列化，
+        // 之后的测试集复用同一上下文，省去密钥生成和重复序列化
+        emit encryptProgress(StageKeygen, 0, 1);
         if (m_context) {
-            PSI_Client_Context_Destory(m_context);
-            m_context = nullptr;
-        }
-
-        // 3. 创建客户端上下文（参数：15, 16, 14）
-        m_context = PSI_Client_Context_Create(15, 16, 14);
-        if (!m_context) {
-            qWarning() << "创建客户端上下文失败";
+            qDebug() << "复用已有客户端上下文";
+        } else if (!createContext()) {
             return false;
         }
-        qDebug() << "客户端上下文创建成功";
-
-        // 4. 生成并序列化上下文
-        C_Stream* ctx_stream = PSI_Client_Context_To_Stream(m_context);
-        if (!ctx_stream) {
-            qWarning() << "序列化上下文失败";
-            return false;
-        }
-
-        size_t ctx_len = 0;
-        const char* ctx_data = PSI_Stream_Read(ctx_stream, &ctx_len);
-        QByteArray contextData(ctx_data, static_cast<int>(ctx_len));
-        contextOut = QString::fromLatin1(contextData.toBase64());
-        qDebug() << "上下文序列化完成，大小：" << ctx_len;
+        contextOut = m_contextBase64;
+        emit encryptProgress(StageKeygen, 1, 1);
 
-        PSI_Stream_Destroy(ctx_stream);
-
-        // 5. 加密查询内容
+        // 4. 加密查询内容
+        emit encryptProgress(StagePacking, 0, 1);
         // 第三个参数是元素个数
-        C_Stream* payload_stream = PSI_Client_Pack_Payload(
-            m_context,
-            cli_data.data(),
-            cli_data.size(),  // 元素个数
-            &m_revealTable
-            );
+        Reveal_Table* revealTable = nullptr;
+        C_Stream* payload_stream = nullptr;
+        {
+            // 复用的上下文可能正被主线程用于解密上一个测试集的结果
+            std::lock_guard<std::mutex> guard(m_context->lock);
+            payload_stream = PSI_Client_Pack_Payload(
+                m_context->handle,
+                cli_data.data(),
+                cli_data.size(),  // 元素个数
+                &revealTable
+                );
+        }
+        if (revealTable) {
+            state->revealTable.reset(revealTable, PSI_Reveal_Table_Destory);
+        }
 
         if (!payload_stream) {
             qWarning() << "加密数据失败";
             return false;
         }
         qDebug() << "数据加密完成";
+        emit encryptProgress(StagePacking, 1, 1);
 
-        // 6. 读取payload
+        // 5. 读取payload
+        emit encryptProgress(StageSerializing, 0, 1);
         size_t payload_len = 0;
         const char* payload_data = PSI_Stream_Read(payload_stream, &payload_len);
         QByteArray payloadBytes(payload_data, static_cast<int>(payload_len));
@@ -131,8 +162,14 @@ bool CryptoWrapper::encryptIdCards(const QStringList& idCards,
         qDebug() << "加密数据序列化完成，大小：" << payload_len;
 
         PSI_Stream_Destroy(payload_stream);
+        emit encryptProgress(StageSerializing, 1, 1);
 
-        // 注意：m_context、m_revealTable 和 m_hashToIdCardMap 保留，用于后续解密
+        // 解密所需的上下文、reveal_table和映射表随本次payload一起交给调用方
+        state->context = m_context;
+        state->contextDigest = m_contextDigest;
+        if (stateOut) {
+            *stateOut = state;
+        }
 
         return true;
     } catch (const std::exception& e) {
@@ -144,12 +181,43 @@ bool CryptoWrapper::encryptIdCards(const QStringList& idCards,
     }
 }
 
-bool CryptoWrapper::decryptResult(const QString& encryptedResult,
+bool CryptoWrapper::createContext()
+{
+    Client_Context_t* context = PSI_Client_Context_Create(kWeight, kEffectiveLambda, kLogPolyMod);
+    if (!context) {
+        qWarning() << "创建客户端上下文失败";
+        return false;
+    }
+    m_context = std::make_shared<ClientContext>(context);
+    qDebug() << "客户端上下文创建成功";
+
+    // 3. 生成并序列化上下文
+    C_Stream* ctx_stream = PSI_Client_Context_To_Stream(m_context->handle);
+    if (!ctx_stream) {
+        qWarning() << "序列化上下文失败";
+        m_context.reset();
+        return false;
+    }
+
+    size_t ctx_len = 0;
+    const char* ctx_data = PSI_Stream_Read(ctx_stream, &ctx_len);
+    QByteArray contextData(ctx_data, static_cast<int>(ctx_len));
+    m_contextBase64 = QString::fromLatin1(contextData.toBase64());
+    m_contextDigest = QString::fromLatin1(
+        QCryptographicHash::hash(contextData, QCryptographicHash::Sha256).toHex());
+    qDebug() << "上下文序列化完成，大小：" << ctx_len << "摘要：" << m_contextDigest;
+
+    PSI_Stream_Destroy(ctx_stream);
+    return true;
+}
+
+bool CryptoWrapper::decryptResult(const RevealState& state,
+                                  const QString& encryptedResult,
                                   QStringList& matchedIdCards)
 {
     // 调用新方法获取完整信息
     QVector<MatchedBlacklistInfo> matchedInfoList;
-    if (!decryptResultWithDetails(encryptedResult, matchedInfoList)) {
+    if (!decryptResultWithDetails(state, encryptedResult, matchedInfoList)) {
         return false;
     }
 
@@ -161,18 +229,19 @@ bool CryptoWrapper::decryptResult(const QString& encryptedResult,
 
     return true;
 }
-bool CryptoWrapper::decryptResultWithDetails(const QString& encryptedResult,
+bool CryptoWrapper::decryptResultWithDetails(const RevealState& state,
+                                             const QString& encryptedResult,
                                              QVector<MatchedBlacklistInfo>& matchedInfoList)
 {
     try {
-        if (!m_context || !m_revealTable) {
+        if (!state.context || !state.revealTable) {
             qWarning() << "解密失败：缺少上下文或reveal_table";
             return false;
         }
 
         qDebug() << "========================================";
         qDebug() << "开始解密结果";
-        qDebug() << "映射表大小：" << m_hashToIdCardMap.size();
+        qDebug() << "映射表大小：" << state.hashIndex.size();
 
         // 1. Base64解码
         QByteArray encryptedData = QByteArray::fromBase64(encryptedResult.toLatin1());
@@ -180,13 +249,17 @@ bool CryptoWrapper::decryptResultWithDetails(const QString& encryptedResult,
 
         // 2. 解密匹配结果
         size_t result_count = 0;
-        Reveal_Result* results = PSI_Client_Reveal_Result(
-            m_context,
-            m_revealTable,
-            encryptedData.data(),
-            static_cast<size_t>(encryptedData.size()),
-            &result_count
-            );
+        Reveal_Result* results = nullptr;
+        {
+            std::lock_guard<std::mutex> guard(state.context->lock);
+            results = PSI_Client_Reveal_Result(
+                state.context->handle,
+                state.revealTable.get(),
+                encryptedData.data(),
+                static_cast<size_t>(encryptedData.size()),
+                &result_count
+                );
+        }
 
         if (!results) {
             qWarning() << "解密失败：PSI_Client_Reveal_Result返回NULL";
@@ -198,6 +271,10 @@ bool CryptoWrapper::decryptResultWithDetails(const QString& encryptedResult,
 
         // 3. 解析每个结果
         matchedInfoList.clear();
+        QVector<uint64_t> packedLabels;
+        QVector<int> packedSlots;
+        packedLabels.reserve(static_cast<int>(result_count));
+        packedSlots.reserve(static_cast<int>(result_count));
 
         for (size_t i = 0; i < result_count; ++i) {
             size_t key = results[i].key;
@@ -216,12 +293,13 @@ bool CryptoWrapper::decryptResultWithDetails(const QString& encryptedResult,
             }
 
             // 通过映射表找回原始身份证号
-            if (!m_hashToIdCardMap.contains(key)) {
+            const int index = state.hashIndex.find(key);
+            if (index < 0) {
                 qWarning() << "  警告：找不到key对应的身份证号，跳过";
                 continue;
             }
 
-            QString idCard = m_hashToIdCardMap[key];
+            QString idCard = state.idCards[index];
             qDebug() << "  身份证号:" << idCard;
 
             // 检查labels数组是否有数据
@@ -230,13 +308,22 @@ bool CryptoWrapper::decryptResultWithDetails(const QString& encryptedResult,
                 continue;
             }
 
-            // 🔥 将所有labels转换为QVector
+            if (value_count == 1) {
+                // 单label紧凑方案，循环结束后批量解码
+                packedLabels.append(values[0]);
+                packedSlots.append(matchedInfoList.size());
+                MatchedBlacklistInfo placeholder;
+                placeholder.idCard = idCard;
+                placeholder.idCardHash = key;
+                matchedInfoList.append(placeholder);
+                continue;
+            }
+
+            // 旧多labels方案
             QVector<uint64_t> labelsVector;
             for (size_t j = 0; j < value_count; ++j) {
                 labelsVector.append(values[j]);
             }
-
-            // 使用多labels解码器解码
             MatchedBlacklistInfo info = BlacklistBitDecoder::decodeFromLabels(labelsVector);
 
             // 设置身份证信息
@@ -246,6 +333,14 @@ bool CryptoWrapper::decryptResultWithDetails(const QString& encryptedResult,
             matchedInfoList.append(info);
         }
 
+        QVector<MatchedBlacklistInfo> decoded = BlacklistBitDecoder::decodePackedBatch(packedLabels);
+        for (int i = 0; i < decoded.size(); ++i) {
+            MatchedBlacklistInfo& slot = matchedInfoList[packedSlots[i]];
+            decoded[i].idCard = slot.idCard;
+            decoded[i].idCardHash = slot.idCardHash;
+            slot = decoded[i];
+        }
+
         qDebug() << "----------------------------------------";
         qDebug() << "最终匹配数量：" << matchedInfoList.size();
         qDebug() << "========================================";
@@ -263,3 +358,23 @@ bool CryptoWrapper::decryptResultWithDetails(const QString& encryptedResult,
         return false;
     }
 }
+
+bool CryptoWrapper::decryptResultsWithDetails(const RevealState& state,
+                                              const QStringList& encryptedResults,
+                                              QVector<MatchedBlacklistInfo>& matchedInfoList)
+{
+    matchedInfoList.clear();
+
+    // 分片之间的黑名单互不重叠，直接拼接各分片的匹配结果
+    for (int i = 0; i < encryptedResults.size(); ++i) {
+        QVector<MatchedBlacklistInfo> shardInfoList;
+        if (!decryptResultWithDetails(state, encryptedResults[i], shardInfoList)) {
+            qWarning() << "解密分片结果失败，分片：" << i;
+            return false;
+        }
+        matchedInfoList += shardInfoList;
+    }
+
+    qDebug() << "分片数量：" << encryptedResults.size() << "合并后匹配数量：" << matchedInfoList.size();
+    return true;
+}
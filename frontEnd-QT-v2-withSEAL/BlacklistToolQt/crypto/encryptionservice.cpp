@@ -0,0 +1,49 @@
+#include "encryptionservice.h"
+#include <QDebug>
+#include <QElapsedTimer>
+
+EncryptionService::EncryptionService(CryptoWrapper* cryptoWrapper, QObject *parent)
+    : QObject(parent)
+    , m_cryptoWrapper(cryptoWrapper)
+    , m_worker(new QObject)
+{
+    // finished从工作线程发出，解密状态经队列连接传回主线程
+    qRegisterMetaType<RevealStatePtr>();
+
+    m_thread.setObjectName("EncryptionWorker");
+    m_worker->moveToThread(&m_thread);
+    m_thread.start();
+}
+
+EncryptionService::~EncryptionService()
+{
+    m_thread.quit();
+    m_thread.wait();
+    delete m_worker;
+}
+
+void EncryptionService::submit(int jobId, const QStringList& idCards)
+{
+    qDebug() << "提交加密任务" << jobId << "，数据量：" << idCards.size();
+
+    QMetaObject::invokeMethod(m_worker, [this, jobId, idCards]() {
+        QElapsedTimer timer;
+        timer.start();
+
+        // 进度在工作线程上同步转发，附上本任务的编号
+        QMetaObject::Connection progressConnection = connect(
+            m_cryptoWrapper, &CryptoWrapper::encryptProgress, m_worker,
+            [this, jobId](CryptoWrapper::EncryptStage stage, int done, int total) {
+                emit progress(jobId, stage, done, total);
+            }, Qt::DirectConnection);
+
+        QString contextData;
+        QString payloadData;
+        RevealStatePtr state;
+        bool success = m_cryptoWrapper->encryptIdCards(idCards, contextData, payloadData, &state);
+        disconnect(progressConnection);
+
+        qDebug() << "加密任务" << jobId << (success ? "完成" : "失败") << "，耗时(ms)：" << timer.elapsed();
+        emit finished(jobId, success, contextData, payloadData, state);
+    }, Qt::QueuedConnection);
+}
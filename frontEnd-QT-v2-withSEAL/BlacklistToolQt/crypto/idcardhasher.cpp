@@ -0,0 +1,348 @@
+#include "idcardhasher.h"
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define IDCARDHASHER_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const uint32_t kInit[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+alignas(16) const uint32_t kRound[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+// 18字节消息的长度字段（比特）
+const uint32_t kMessageBits = IdCardHasher::kIdLength * 8;
+
+inline uint32_t loadBe32(const unsigned char* p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+inline uint32_t rotr(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+/**
+ * 填充后的分组：W0-W3为前16字节，W4为后2字节+0x80，W5-W14为0，W15为消息比特数
+ */
+inline void loadBlockWords(const char* id, uint32_t w[16])
+{
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(id);
+    w[0] = loadBe32(p);
+    w[1] = loadBe32(p + 4);
+    w[2] = loadBe32(p + 8);
+    w[3] = loadBe32(p + 12);
+    w[4] = (uint32_t(p[16]) << 24) | (uint32_t(p[17]) << 16) | 0x8000u;
+    for (int i = 5; i < 15; ++i) {
+        w[i] = 0;
+    }
+    w[15] = kMessageBits;
+}
+
+uint64_t hashScalar(const char* id)
+{
+    uint32_t w[64];
+    loadBlockWords(id, w);
+    for (int i = 16; i < 64; ++i) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = kInit[0], b = kInit[1], c = kInit[2], d = kInit[3];
+    uint32_t e = kInit[4], f = kInit[5], g = kInit[6], h = kInit[7];
+    for (int i = 0; i < 64; ++i) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + kRound[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    // 只需要摘要的前8字节，即H0和H1
+    return (uint64_t(kInit[0] + a) << 32) | (kInit[1] + b);
+}
+
+void hashBatchScalar(const char* ids, size_t count, uint64_t* out)
+{
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = hashScalar(ids + i * IdCardHasher::kIdLength);
+    }
+}
+
+#ifdef IDCARDHASHER_X86
+
+// ---------- AVX2：8个身份证号并行，每个32位通道一路 ----------
+
+#define IDH_AVX2 __attribute__((target("avx2")))
+
+IDH_AVX2 inline __m256i rotr8(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+IDH_AVX2 void hash8Avx2(const char* ids, uint64_t* out)
+{
+    // 按字转置：w[i]的第j个通道是第j个身份证号的W[i]
+    alignas(32) uint32_t lanes[5][8];
+    for (int j = 0; j < 8; ++j) {
+        uint32_t words[16];
+        loadBlockWords(ids + j * IdCardHasher::kIdLength, words);
+        for (int i = 0; i < 5; ++i) {
+            lanes[i][j] = words[i];
+        }
+    }
+
+    __m256i w[64];
+    for (int i = 0; i < 5; ++i) {
+        w[i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes[i]));
+    }
+    for (int i = 5; i < 15; ++i) {
+        w[i] = _mm256_setzero_si256();
+    }
+    w[15] = _mm256_set1_epi32(static_cast<int>(kMessageBits));
+    for (int i = 16; i < 64; ++i) {
+        __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[i - 15], 7), rotr8(w[i - 15], 18)),
+                                      _mm256_srli_epi32(w[i - 15], 3));
+        __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(w[i - 2], 17), rotr8(w[i - 2], 19)),
+                                      _mm256_srli_epi32(w[i - 2], 10));
+        w[i] = _mm256_add_epi32(_mm256_add_epi32(w[i - 16], s0), _mm256_add_epi32(w[i - 7], s1));
+    }
+
+    __m256i a = _mm256_set1_epi32(static_cast<int>(kInit[0]));
+    __m256i b = _mm256_set1_epi32(static_cast<int>(kInit[1]));
+    __m256i c = _mm256_set1_epi32(static_cast<int>(kInit[2]));
+    __m256i d = _mm256_set1_epi32(static_cast<int>(kInit[3]));
+    __m256i e = _mm256_set1_epi32(static_cast<int>(kInit[4]));
+    __m256i f = _mm256_set1_epi32(static_cast<int>(kInit[5]));
+    __m256i g = _mm256_set1_epi32(static_cast<int>(kInit[6]));
+    __m256i h = _mm256_set1_epi32(static_cast<int>(kInit[7]));
+
+    for (int i = 0; i < 64; ++i) {
+        __m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(rotr8(e, 6), rotr8(e, 11)), rotr8(e, 25));
+        __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, sigma1),
+                                      _mm256_add_epi32(ch, _mm256_add_epi32(
+                                          _mm256_set1_epi32(static_cast<int>(kRound[i])), w[i])));
+        __m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(rotr8(a, 2), rotr8(a, 13)), rotr8(a, 22));
+        __m256i maj = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+                                       _mm256_and_si256(b, c));
+        __m256i t2 = _mm256_add_epi32(sigma0, maj);
+        h = g; g = f; f = e; e = _mm256_add_epi32(d, t1);
+        d = c; c = b; b = a; a = _mm256_add_epi32(t1, t2);
+    }
+
+    alignas(32) uint32_t h0[8];
+    alignas(32) uint32_t h1[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(h0), _mm256_add_epi32(a, _mm256_set1_epi32(static_cast<int>(kInit[0]))));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(h1), _mm256_add_epi32(b, _mm256_set1_epi32(static_cast<int>(kInit[1]))));
+    for (int j = 0; j < 8; ++j) {
+        out[j] = (uint64_t(h0[j]) << 32) | h1[j];
+    }
+}
+
+IDH_AVX2 void hashBatchAvx2(const char* ids, size_t count, uint64_t* out)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        hash8Avx2(ids + i * IdCardHasher::kIdLength, out + i);
+    }
+    hashBatchScalar(ids + i * IdCardHasher::kIdLength, count - i, out + i);
+}
+
+// ---------- SHA-NI：硬件分组压缩，多路交错隐藏sha256rnds2的延迟 ----------
+
+#define IDH_SHANI __attribute__((target("sha,sse4.1")))
+
+template <int Ways>
+IDH_SHANI inline void hashShaNiN(const char* ids, uint64_t* out)
+{
+    const __m128i byteSwap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // 初始状态排列为ABEF/CDGH
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&kInit[0]));
+    __m128i cdghInit = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&kInit[4]));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    cdghInit = _mm_shuffle_epi32(cdghInit, 0x1B);
+    const __m128i abefInit = _mm_alignr_epi8(tmp, cdghInit, 8);
+    cdghInit = _mm_blend_epi16(cdghInit, tmp, 0xF0);
+
+    __m128i state0[Ways];
+    __m128i state1[Ways];
+    __m128i msgs[Ways][4];
+    for (int w = 0; w < Ways; ++w) {
+        // 构造填充后的分组
+        alignas(16) unsigned char block[64] = {0};
+        std::memcpy(block, ids + w * IdCardHasher::kIdLength, IdCardHasher::kIdLength);
+        block[IdCardHasher::kIdLength] = 0x80;
+        block[62] = static_cast<unsigned char>(kMessageBits >> 8);
+        block[63] = static_cast<unsigned char>(kMessageBits);
+        for (int i = 0; i < 4; ++i) {
+            msgs[w][i] = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block + 16 * i)), byteSwap);
+        }
+        state0[w] = abefInit;
+        state1[w] = cdghInit;
+    }
+
+    // 每组4轮；第3-14组生成下一组消息字，第1-12组做msg1预处理
+    for (int group = 0; group < 16; ++group) {
+        const __m128i k = _mm_load_si128(reinterpret_cast<const __m128i*>(&kRound[4 * group]));
+        for (int w = 0; w < Ways; ++w) {
+            __m128i* m = msgs[w];
+            __m128i msg = _mm_add_epi32(m[group & 3], k);
+            state1[w] = _mm_sha256rnds2_epu32(state1[w], state0[w], msg);
+            if (group >= 3 && group <= 14) {
+                __m128i& next = m[(group + 1) & 3];
+                next = _mm_add_epi32(next, _mm_alignr_epi8(m[group & 3], m[(group + 3) & 3], 4));
+                next = _mm_sha256msg2_epu32(next, m[group & 3]);
+            }
+            msg = _mm_shuffle_epi32(msg, 0x0E);
+            state0[w] = _mm_sha256rnds2_epu32(state0[w], state1[w], msg);
+            if (group >= 1 && group <= 12) {
+                m[(group + 3) & 3] = _mm_sha256msg1_epu32(m[(group + 3) & 3], m[group & 3]);
+            }
+        }
+    }
+
+    for (int w = 0; w < Ways; ++w) {
+        // state0 = [F, E, B, A]（从低到高），只需要H0(A)和H1(B)
+        const __m128i abef = _mm_add_epi32(state0[w], abefInit);
+        const uint32_t hA = static_cast<uint32_t>(_mm_extract_epi32(abef, 3));
+        const uint32_t hB = static_cast<uint32_t>(_mm_extract_epi32(abef, 2));
+        out[w] = (uint64_t(hA) << 32) | hB;
+    }
+}
+
+IDH_SHANI uint64_t hashShaNi(const char* id)
+{
+    uint64_t result;
+    hashShaNiN<1>(id, &result);
+    return result;
+}
+
+IDH_SHANI void hashBatchShaNi(const char* ids, size_t count, uint64_t* out)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        hashShaNiN<4>(ids + i * IdCardHasher::kIdLength, out + i);
+    }
+    for (; i < count; ++i) {
+        out[i] = hashShaNi(ids + i * IdCardHasher::kIdLength);
+    }
+}
+
+bool cpuHasShaNi()
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1)) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & (1u << 29)) != 0;
+}
+
+bool cpuHasAvx2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif // IDCARDHASHER_X86
+
+using BatchFn = void (*)(const char*, size_t, uint64_t*);
+using OneFn = uint64_t (*)(const char*);
+
+struct Implementation {
+    BatchFn batch;
+    OneFn one;
+    const char* name;
+};
+
+Implementation selectImplementation()
+{
+#ifdef IDCARDHASHER_X86
+    // 批量时8路AVX2略快于4路交错的SHA-NI；单个哈希时SHA-NI更快
+    const bool shaNi = cpuHasShaNi();
+    if (cpuHasAvx2()) {
+        return {hashBatchAvx2, shaNi ? hashShaNi : hashScalar, shaNi ? "avx2+sha-ni" : "avx2"};
+    }
+    if (shaNi) {
+        return {hashBatchShaNi, hashShaNi, "sha-ni"};
+    }
+#endif
+    return {hashBatchScalar, hashScalar, "scalar"};
+}
+
+const Implementation& implementation()
+{
+    static const Implementation impl = selectImplementation();
+    return impl;
+}
+
+} // namespace
+
+namespace IdCardHasher {
+
+void hashBatch(const char* ids, size_t count, uint64_t* out)
+{
+    implementation().batch(ids, count, out);
+}
+
+uint64_t hashOne(const char* id)
+{
+    return implementation().one(id);
+}
+
+const char* implementationName()
+{
+    return implementation().name;
+}
+
+} // namespace IdCardHasher
+
+void IdCardHashTable::build(const uint64_t* keys, size_t count)
+{
+    size_t capacity = 16;
+    while (capacity < count * 2) {
+        capacity <<= 1;
+    }
+    m_slots.assign(capacity, Slot{0, -1});
+    m_mask = capacity - 1;
+    m_size = 0;
+
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t key = keys[i];
+        size_t pos = key & m_mask;
+        while (m_slots[pos].index >= 0 && m_slots[pos].key != key) {
+            pos = (pos + 1) & m_mask;
+        }
+        if (m_slots[pos].index < 0) {
+            ++m_size;
+        }
+        m_slots[pos] = Slot{key, static_cast<int32_t>(i)};
+    }
+}
+
+void IdCardHashTable::clear()
+{
+    m_slots.clear();
+    m_mask = 0;
+    m_size = 0;
+}
@@ -35,8 +35,10 @@ public:
                            std::function<void(const QJsonObject&)> onSuccess,
                            std::function<void(const QString&)> onError);
     
+    // context为空时只发送contextDigest，由后端使用已缓存的上下文
     void queryBlacklistWithData(const QString& payload,
                                 const QString& context,
+                                const QString& contextDigest,
                                 std::function<void(const QJsonObject&)> onSuccess,
                                 std::function<void(const QString&)> onError);
 
@@ -2,14 +2,16 @@
 #define BLACKLISTBITDECODER_H
 
 #include "blacklistinfo.h"
+#include "blacklistlabelcodec.h"
 #include <cstdint>
 #include <QDebug>
 #include <QVector>
 
 /**
- * @brief 黑名单信息位解码工具（多labels方案）
+ * @brief 黑名单信息位解码工具
  *
- * 编码格式：
+ * 当前编码为单label紧凑方案，位布局见blacklistlabelcodec.h。
+ * 仍兼容旧的多labels方案（labels多于1个时）：
  * labels[0]: [3-0]位=行为评级, [7-4]位=行为记录数
  * labels[1]: [3-0]位=记录1行为类型, [7-4]位=记录1使用工具
  * labels[2]: [3-0]位=记录2行为类型, [7-4]位=记录2使用工具
@@ -31,6 +33,11 @@ public:
             return info;
         }
 
+        if (labels.size() == 1) {
+            return decodePacked(labels[0]);
+        }
+
+        // 旧多labels方案
         // 解码labels[0]: 行为评级 + 记录数
         uint64_t label0 = labels[0];
         info.riskLevel = static_cast<int>(label0 & 0xF);
@@ -62,28 +69,63 @@ public:
     }
 
     /**
-     * @brief 解码labels[0]获取行为评级
+     * @brief 解码单个打包label
      */
-    static int decodeRiskLevel(uint64_t label0) {
-        return static_cast<int>(label0 & 0xF);
-    }
+    static MatchedBlacklistInfo decodePacked(uint64_t label) {
+        using namespace BlacklistLabelCodec;
 
-    /**
-     * @brief 解码labels[0]获取行为记录数
-     */
-    static int decodeRecordCount(uint64_t label0) {
-        return static_cast<int>((label0 >> 4) & 0xF);
+        MatchedBlacklistInfo info;
+        info.idCardHash = 0;
+        info.riskLevel = riskLevel(label);
+        info.recordCount = recordCount(label);
+
+        const BehaviorRecordInfo records[kMaxRecords] = {
+            {behaviorType<0>(label), toolType<0>(label)},
+            {behaviorType<1>(label), toolType<1>(label)},
+            {behaviorType<2>(label), toolType<2>(label)},
+        };
+        for (int i = 0; i < info.recordCount; i++) {
+            info.records.append(records[i]);
+        }
+        return info;
     }
 
     /**
-     * @brief 解码行为记录label
-     * @return [行为类型, 使用工具]
+     * @brief 批量解码打包label，字段解码由BlacklistLabelCodec::decodeBatch向量化完成
+     * @param labels 每个元素对应一条匹配结果
+     * @return 与labels一一对应的解码结果（idCard/idCardHash由调用方填写）
      */
-    static BehaviorRecordInfo decodeBehaviorLabel(uint64_t label) {
-        BehaviorRecordInfo record;
-        record.behaviorType = static_cast<int>(label & 0xF);
-        record.toolType = static_cast<int>((label >> 4) & 0xF);
-        return record;
+    static QVector<MatchedBlacklistInfo> decodePackedBatch(const QVector<uint64_t>& labels) {
+        using namespace BlacklistLabelCodec;
+
+        const size_t n = static_cast<size_t>(labels.size());
+        QVector<uint8_t> columns(static_cast<int>(n) * (2 + 2 * kMaxRecords));
+        uint8_t* base = columns.data();
+
+        DecodedBatch batch;
+        batch.risk = base;
+        batch.count = base + n;
+        for (int r = 0; r < kMaxRecords; ++r) {
+            batch.behavior[r] = base + (2 + 2 * r) * n;
+            batch.tool[r] = base + (3 + 2 * r) * n;
+        }
+        decodeBatch(labels.constData(), n, batch);
+
+        QVector<MatchedBlacklistInfo> result(static_cast<int>(n));
+        for (size_t i = 0; i < n; ++i) {
+            MatchedBlacklistInfo& info = result[static_cast<int>(i)];
+            info.idCardHash = 0;
+            info.riskLevel = batch.risk[i];
+            info.recordCount = batch.count[i];
+            info.records.reserve(info.recordCount);
+            for (int r = 0; r < info.recordCount; ++r) {
+                BehaviorRecordInfo record;
+                record.behaviorType = batch.behavior[r][i];
+                record.toolType = batch.tool[r][i];
+                info.records.append(record);
+            }
+        }
+        return result;
     }
 };
 
@@ -0,0 +1,107 @@
+#ifndef BLACKLISTLABELCODEC_H
+#define BLACKLISTLABELCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 黑名单单label紧凑编码（与Java端BlacklistBitEncoder一致）
+ *
+ * 每个字段2位，共16位：
+ * [1-0]位=行为评级, [3-2]位=行为记录数,
+ * [5-4]位=记录1行为类型, [7-6]位=记录1使用工具,
+ * [9-8]位=记录2行为类型, [11-10]位=记录2使用工具,
+ * [13-12]位=记录3行为类型, [15-14]位=记录3使用工具
+ *
+ * 打包结果须小于BFV明文模数才能无损往返：明文模数是kPlainModulusBits位的素数，
+ * 不小于2^(kPlainModulusBits-1)，因此要求kTotalBits < kPlainModulusBits。
+ */
+namespace BlacklistLabelCodec {
+
+constexpr unsigned kFieldBits = 2;
+constexpr uint64_t kFieldMask = (uint64_t(1) << kFieldBits) - 1;
+constexpr int kMaxRecords = 3;
+
+constexpr unsigned kRiskShift = 0;
+constexpr unsigned kCountShift = 2;
+constexpr unsigned kRecordShift = 4;
+constexpr unsigned kRecordBits = 2 * kFieldBits;
+constexpr unsigned kTotalBits = kRecordShift + kMaxRecords * kRecordBits;
+
+// libpsi为(15, 16, 14)上下文选取的BFV明文模数位数（batching所需素数的量级）
+constexpr unsigned kPlainModulusBits = 20;
+
+template <unsigned Shift>
+constexpr int field(uint64_t label)
+{
+    return static_cast<int>((label >> Shift) & kFieldMask);
+}
+
+constexpr int riskLevel(uint64_t label) { return field<kRiskShift>(label); }
+constexpr int recordCount(uint64_t label) { return field<kCountShift>(label); }
+
+template <int Index>
+constexpr int behaviorType(uint64_t label)
+{
+    static_assert(Index >= 0 && Index < kMaxRecords, "记录下标越界");
+    return field<kRecordShift + Index * kRecordBits>(label);
+}
+
+template <int Index>
+constexpr int toolType(uint64_t label)
+{
+    static_assert(Index >= 0 && Index < kMaxRecords, "记录下标越界");
+    return field<kRecordShift + Index * kRecordBits + kFieldBits>(label);
+}
+
+/**
+ * @brief 打包（用于自测和调试）
+ * @param behaviors/tools 长度为count的数组
+ */
+constexpr uint64_t pack(int risk, int count, const int* behaviors, const int* tools)
+{
+    uint64_t label = (uint64_t(risk) & kFieldMask) << kRiskShift
+                   | (uint64_t(count) & kFieldMask) << kCountShift;
+    for (int i = 0; i < count && i < kMaxRecords; ++i) {
+        label |= (uint64_t(behaviors[i]) & kFieldMask) << (kRecordShift + i * kRecordBits);
+        label |= (uint64_t(tools[i]) & kFieldMask) << (kRecordShift + i * kRecordBits + kFieldBits);
+    }
+    return label;
+}
+
+static_assert(kTotalBits < kPlainModulusBits, "打包label须小于BFV明文模数");
+static_assert(behaviorType<2>(uint64_t(1) << 12) == 1 && toolType<2>(uint64_t(2) << 14) == 2, "位布局错误");
+
+/**
+ * @brief 批量解码结果（按字段分列存放）
+ */
+struct DecodedBatch {
+    uint8_t* risk;
+    uint8_t* count;
+    uint8_t* behavior[kMaxRecords];
+    uint8_t* tool[kMaxRecords];
+};
+
+/**
+ * @brief 批量解码n个打包label
+ *
+ * 各字段都是固定移位加掩码、循环内无分支，编译器可自动向量化。
+ */
+inline void decodeBatch(const uint64_t* labels, size_t n, const DecodedBatch& out)
+{
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t label = labels[i];
+        out.risk[i] = static_cast<uint8_t>(riskLevel(label));
+        out.count[i] = static_cast<uint8_t>(recordCount(label));
+        out.behavior[0][i] = static_cast<uint8_t>(behaviorType<0>(label));
+        out.tool[0][i] = static_cast<uint8_t>(toolType<0>(label));
+        out.behavior[1][i] = static_cast<uint8_t>(behaviorType<1>(label));
+        out.tool[1][i] = static_cast<uint8_t>(toolType<1>(label));
+        out.behavior[2][i] = static_cast<uint8_t>(behaviorType<2>(label));
+        out.tool[2][i] = static_cast<uint8_t>(toolType<2>(label));
+    }
+}
+
+} // namespace BlacklistLabelCodec
+
+#endif // BLACKLISTLABELCODEC_H
@@ -28,6 +28,7 @@ private slots:
     
     void onTestSetCreateSuccess();
     void onTestSetCreateFailed(const QString& error);
+    void onTestSetCreateProgress(const QString& stage, int percent);
     void onQuerySuccess();
     void onQueryFailed(const QString& error);
     void onExportSuccess(const QString& filename);
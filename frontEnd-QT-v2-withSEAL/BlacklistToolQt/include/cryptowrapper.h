@@ -6,12 +6,49 @@
 #include <QStringList>
 #include <QMap>
 #include <QVector>
+#include <memory>
+#include <mutex>
 #include "blacklistinfo.h"  // 新增
+#include "idcardhasher.h"
 
 // 前向声明
 struct Client_Context_t;
 struct Reveal_Table;
 
+/**
+ * @brief 客户端上下文句柄，最后一个引用释放时销毁上下文
+ *
+ * 同一上下文可能同时被工作线程加密和主线程解密使用，libpsi不保证并发安全，
+ * 调用PSI_Client_*时须持有lock。
+ */
+struct ClientContext {
+    explicit ClientContext(Client_Context_t* handle) : handle(handle) {}
+    ~ClientContext();
+    ClientContext(const ClientContext&) = delete;
+    ClientContext& operator=(const ClientContext&) = delete;
+
+    Client_Context_t* const handle;
+    std::mutex lock;
+};
+
+/**
+ * @brief 一次加密对应的解密状态
+ *
+ * 与该次加密生成的payload一一对应，查询结果只能用生成该payload时的状态解密。
+ * 上下文可能被之后的加密复用，按引用计数共享，最后一个引用释放时才销毁，
+ * 新的加密替换或失败都不会影响已有的状态。创建后只读，可在线程间传递。
+ */
+struct RevealState {
+    std::shared_ptr<ClientContext> context;
+    std::shared_ptr<Reveal_Table> revealTable;
+    QString contextDigest;     // 上下文的SHA256摘要（十六进制）
+
+    // 哈希值到身份证号的映射，用于解密后还原
+    QStringList idCards;
+    IdCardHashTable hashIndex;
+};
+using RevealStatePtr = std::shared_ptr<const RevealState>;
+
 class CryptoWrapper : public QObject
 {
     Q_OBJECT
@@ -19,9 +56,18 @@ public:
     explicit CryptoWrapper(QObject *parent = nullptr);
     ~CryptoWrapper();
 
+    // 加密阶段
+    enum EncryptStage {
+        StageHashing,      // 身份证哈希
+        StageKeygen,       // 生成或复用上下文
+        StagePacking,      // PSI_Client_Pack_Payload
+        StageSerializing   // payload序列化为Base64
+    };
+    Q_ENUM(EncryptStage)
+
     /**
      * 将身份证号转换为size_t类型的key
-     * 使用SHA256哈希算法
+     * 使用SHA256哈希算法，18位身份证号走IdCardHasher的单分组快速路径
      */
     static size_t hashIdCard(const QString& idCard);
 
@@ -30,36 +76,70 @@ public:
      * @param idCards 身份证号列表
      * @param contextOut 输出：Base64编码的上下文数据
      * @param payloadOut 输出：Base64编码的加密负载
+     * @param stateOut 输出：本次加密的解密状态，失败时不修改
      * @return 成功返回true
      */
     bool encryptIdCards(const QStringList& idCards,
                         QString& contextOut,
-                        QString& payloadOut);
+                        QString& payloadOut,
+                        RevealStatePtr* stateOut = nullptr);
 
     /**
      * 解密查询结果，返回匹配的身份证号列表（旧版本，兼容用）
+     * @param state 生成该次查询payload时的解密状态
      * @param encryptedResult Base64编码的加密结果
      * @param matchedIdCards 输出：匹配的身份证号列表
      * @return 成功返回true
      */
-    bool decryptResult(const QString& encryptedResult,
-                       QStringList& matchedIdCards);
+    static bool decryptResult(const RevealState& state,
+                              const QString& encryptedResult,
+                              QStringList& matchedIdCards);
 
     /**
      * 解密查询结果，返回完整的黑名单信息（新版本）
+     * @param state 生成该次查询payload时的解密状态
      * @param encryptedResult Base64编码的加密结果
      * @param matchedInfoList 输出：匹配的黑名单完整信息列表
      * @return 成功返回true
      */
-    bool decryptResultWithDetails(const QString& encryptedResult,
-                                  QVector<MatchedBlacklistInfo>& matchedInfoList);
+    static bool decryptResultWithDetails(const RevealState& state,
+                                         const QString& encryptedResult,
+                                         QVector<MatchedBlacklistInfo>& matchedInfoList);
+
+    /**
+     * 解密多个psisrv分片返回的结果并合并
+     * 各分片使用同一份payload计算，共用同一个reveal_table
+     * @param state 生成该次查询payload时的解密状态
+     * @param encryptedResults 各分片Base64编码的加密结果
+     * @param matchedInfoList 输出：合并后的匹配信息列表
+     * @return 全部分片解密成功返回true
+     */
+    static bool decryptResultsWithDetails(const RevealState& state,
+                                          const QStringList& encryptedResults,
+                                          QVector<MatchedBlacklistInfo>& matchedInfoList);
+
+signals:
+    /**
+     * 加密进度，encryptIdCards执行过程中发出（可能来自工作线程）
+     * @param done 当前阶段已完成量
+     * @param total 当前阶段总量
+     */
+    void encryptProgress(CryptoWrapper::EncryptStage stage, int done, int total);
 
 private:
-    Client_Context_t* m_context;
-    Reveal_Table* m_revealTable;
+    /**
+     * 创建客户端上下文并序列化
+     */
+    bool createContext();
 
-    // 保存哈希值到身份证号的映射，用于解密后还原
-    QMap<size_t, QString> m_hashToIdCardMap;
+    // 最近一次加密使用的上下文，下次加密可直接复用；已发出的RevealState各自持有引用
+    std::shared_ptr<ClientContext> m_context;
+
+    // 序列化后的上下文（Base64），上下文复用期间不必重新序列化
+    QString m_contextBase64;
+    QString m_contextDigest;
 };
 
+Q_DECLARE_METATYPE(RevealStatePtr)
+
 #endif // CRYPTOWRAPPER_H
@@ -0,0 +1,53 @@
+#ifndef ENCRYPTIONSERVICE_H
+#define ENCRYPTIONSERVICE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include "cryptowrapper.h"
+
+/**
+ * @brief 异步加密服务
+ *
+ * 在独立的工作线程上执行CryptoWrapper::encryptIdCards，避免密钥生成、哈希和
+ * PSI_Client_Pack_Payload阻塞界面。任务按提交顺序在工作线程上串行执行，
+ * 阶段进度通过progress发出，与finished一样带有任务编号。
+ *
+ * 每个任务的解密状态随finished一起返回，调用方用它解密对应payload的查询结果，
+ * 不受之后提交的任务影响。
+ */
+class EncryptionService : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EncryptionService(CryptoWrapper* cryptoWrapper, QObject *parent = nullptr);
+    ~EncryptionService();
+
+    /**
+     * @brief 提交一个加密任务
+     * @param jobId 任务编号，随finished信号原样返回
+     * @param idCards 身份证号列表
+     */
+    void submit(int jobId, const QStringList& idCards);
+
+signals:
+    /**
+     * @brief 任务的加密阶段进度
+     */
+    void progress(int jobId, CryptoWrapper::EncryptStage stage, int done, int total);
+
+    /**
+     * @brief 任务完成，失败时state为空
+     */
+    void finished(int jobId, bool success, const QString& contextData, const QString& payloadData,
+                  const RevealStatePtr& state);
+
+private:
+    CryptoWrapper* m_cryptoWrapper;
+    QThread m_thread;
+    QObject* m_worker;    // 工作线程上的任务执行对象
+};
+
+#endif // ENCRYPTIONSERVICE_H
@@ -0,0 +1,88 @@
+#ifndef IDCARDHASHER_H
+#define IDCARDHASHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 身份证号批量哈希
+ *
+ * 与CryptoWrapper::hashIdCard、Java端IdCardHashUtil结果一致：SHA256后取前8字节（大端）。
+ * 身份证号固定18字节，填充后恰好是一个SHA256分组，因此每个身份证号只需一次压缩，
+ * 不需要QByteArray和QCryptographicHash的分配与状态管理。
+ *
+ * 运行时按CPU能力选择实现：批量优先AVX2（8路多缓冲），其次SHA-NI（4路交错），最后标量；
+ * 单个哈希优先SHA-NI。
+ */
+namespace IdCardHasher {
+
+constexpr size_t kIdLength = 18;
+
+/**
+ * @brief 批量哈希
+ * @param ids 连续存放的count个身份证号，每个kIdLength字节，无分隔符
+ * @param count 身份证号个数
+ * @param out 输出count个哈希值
+ */
+void hashBatch(const char* ids, size_t count, uint64_t* out);
+
+/**
+ * @brief 哈希单个18字节身份证号
+ */
+uint64_t hashOne(const char* id);
+
+/**
+ * @brief 当前使用的实现名称，用于日志
+ */
+const char* implementationName();
+
+} // namespace IdCardHasher
+
+/**
+ * @brief 身份证哈希 → 下标的开放寻址表
+ *
+ * 替代QMap<size_t, QString>：键是均匀分布的SHA256截断值，直接取低位定槽、线性探测，
+ * 表容量为2的幂且不低于元素数的2倍。重复的键以最后一次写入为准（与QMap一致）。
+ */
+class IdCardHashTable {
+public:
+    /**
+     * @brief 用keys重建表，keys[i]对应下标i
+     */
+    void build(const uint64_t* keys, size_t count);
+
+    /**
+     * @brief 查找键对应的下标，不存在返回-1
+     */
+    int find(uint64_t key) const {
+        if (m_slots.empty()) {
+            return -1;
+        }
+        for (size_t pos = key & m_mask; ; pos = (pos + 1) & m_mask) {
+            const Slot& slot = m_slots[pos];
+            if (slot.index < 0) {
+                return -1;
+            }
+            if (slot.key == key) {
+                return slot.index;
+            }
+        }
+    }
+
+    bool contains(uint64_t key) const { return find(key) >= 0; }
+    size_t size() const { return m_size; }
+    void clear();
+
+private:
+    struct Slot {
+        uint64_t key;
+        int32_t index;   // -1表示空槽
+    };
+
+    std::vector<Slot> m_slots;
+    size_t m_mask = 0;
+    size_t m_size = 0;
+};
+
+#endif // IDCARDHASHER_H
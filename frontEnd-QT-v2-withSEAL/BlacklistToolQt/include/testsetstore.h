@@ -7,7 +7,9 @@
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QJsonValue>
+#include <QDateTime>
 #include "cryptowrapper.h"  // 添加这一行
+#include "encryptionservice.h"
 #include "blacklistinfo.h"
 
 class TestSetStore : public QObject
@@ -66,6 +68,7 @@ signals:
     
     void testSetCreateSuccess();
     void testSetCreateFailed(const QString& error);
+    void testSetCreateProgress(const QString& stage, int percent);  // 加密阶段进度
     void querySuccess();
     void queryFailed(const QString& error);
     void exportSuccess(const QString& filename);
@@ -74,7 +77,18 @@ signals:
 private:
     QString m_cachedContextData;   // 缓存的上下文数据
     QString m_cachedPayloadData;   // 缓存的负载数据
+    RevealStatePtr m_cachedRevealState;  // 与缓存负载对应的解密状态
     QString m_cachedEncryptedResult; // 缓存加密的查询结果（用于解密）
+    bool m_contextAccepted = false;  // 后端是否已缓存当前上下文（可只发送摘要）
+
+    // 发送查询请求，withContext为false时只发送上下文摘要
+    // 结果只在revealState仍是当前测试集的解密状态时采用
+    void sendQuery(const RevealStatePtr& revealState, const QString& payloadData,
+                   const QString& contextData, bool withContext, const QDateTime& startTime);
+    // 工作线程加密完成
+    void onEncryptFinished(int jobId, bool success, const QString& contextData, const QString& payloadData,
+                           const RevealStatePtr& state);
+    void onEncryptProgress(int jobId, CryptoWrapper::EncryptStage stage, int done, int total);
     explicit TestSetStore(QObject *parent = nullptr);
     ~TestSetStore();
     TestSetStore(const TestSetStore&) = delete;
@@ -100,6 +114,15 @@ private:
 
     // 加密工具
     CryptoWrapper m_cryptoWrapper;  // 添加这一行
+    // 异步加密服务（须在m_cryptoWrapper之后声明，先于它析构）
+    EncryptionService m_encryptionService;
+
+    // 创建请求编号，只有最新一次创建的结果会被采用
+    int m_createSeq = 0;
+    // 最近提交加密的测试集，加密完成后才替换当前测试集
+    int m_encryptingInsideSize = 0;
+    int m_encryptingOutsideSize = 0;
+    QStringList m_encryptingTestSet;
 
     QVector<MatchedBlacklistInfo> m_matchedInfoList;  // 存储匹配的完整信息
     // 🔥 新增：保存原始测试集数据
@@ -68,12 +68,16 @@ void ApiService::saveEncryptedData(const QString& payload,
 
 void ApiService::queryBlacklistWithData(const QString& payload,
                                         const QString& context,
+                                        const QString& contextDigest,
                                         std::function<void(const QJsonObject&)> onSuccess,
                                         std::function<void(const QString&)> onError)
 {
     QJsonObject requestBody;
     requestBody["payloadData"] = payload;
-    requestBody["contextData"] = context;
+    if (!context.isEmpty()) {
+        requestBody["contextData"] = context;
+    }
+    requestBody["contextDigest"] = contextDigest;
 
     qDebug() << "发送查询请求，数据大小 - payload:" << payload.size() << "context:" << context.size();
 
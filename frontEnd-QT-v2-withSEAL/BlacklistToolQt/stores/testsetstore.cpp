@@ -4,6 +4,7 @@
 #include "xlsxformat.h"
 #include <QDateTime>
 #include <QFileDialog>
+#include <QJsonArray>
 #include <QStandardPaths>
 #include <QFile>
 #include <QDebug>
@@ -20,7 +21,12 @@ TestSetStore::TestSetStore(QObject *parent)
     , m_totalCount(0)
     , m_queryTime(0.0)
     , m_queryStartTime(0)
+    , m_encryptionService(&m_cryptoWrapper)
 {
+    connect(&m_encryptionService, &EncryptionService::finished,
+            this, &TestSetStore::onEncryptFinished);
+    connect(&m_encryptionService, &EncryptionService::progress,
+            this, &TestSetStore::onEncryptProgress);
 }
 
 TestSetStore::~TestSetStore()
@@ -101,12 +107,17 @@ void TestSetStore::setQueryResult(int matched, int total, double time)
 void TestSetStore::createTestSet(int insideSize, int outsideSize)
 {
     setTestSetStatus(Creating);
-    m_pendingInsideSize = insideSize;
-    m_pendingOutsideSize = outsideSize;
+    const int createId = ++m_createSeq;
 
     // 第一步：调用Java后端生成测试集明文
     ApiService::instance().createTestSet(insideSize, outsideSize,
-       [this](const QJsonObject& response) {
+       [this, createId, insideSize, outsideSize](const QJsonObject& response) {
+           // 期间又发起了新的创建，本次结果作废
+           if (createId != m_createSeq) {
+               qDebug() << "测试集创建请求" << createId << "已被新的请求取代";
+               return;
+           }
+
            int code = response.value("code").toInt();
            if (code != 200) {
                setTestSetStatus(CreateFailed);
@@ -123,56 +134,18 @@ void TestSetStore::createTestSet(int insideSize, int outsideSize)
                idCards.append(val.toString());
            }
            qDebug() << "收到测试集数据，数量：" << idCards.size();
-           // 🔥 保存原始测试集
-           m_originalTestSet = idCards;
-
-           // 🔥 保存库内身份证集合（最后一位是X的）
-           m_insideIdCards.clear();
-           for (const QString& idCard : idCards) {
-               if (idCard.endsWith('X')) {
-                   m_insideIdCards.insert(idCard);
-               }
-           }
-           qDebug() << "库内数量：" << m_insideIdCards.size();
-           qDebug() << "库外数量：" << (idCards.size() - m_insideIdCards.size());
-
-           // 🔥 添加详细日志
-           qDebug() << "========== Qt收到的测试集 ==========";
-           qDebug() << "总数：" << idCards.size();
-           for (int i = 0; i < idCards.size(); ++i) {
-               QString idCard = idCards[i];
-               size_t hash = CryptoWrapper::hashIdCard(idCard);
-               qDebug() << QString("[%1] 身份证: %2, 哈希: %3")
-                               .arg(i).arg(idCard).arg(hash);
-           }
-           qDebug() << "====================================";
 
-           // 第二步：Qt端加密数据
-           QString contextData;
-           QString payloadData;
-           bool success = m_cryptoWrapper.encryptIdCards(idCards, contextData, payloadData);
-           if (!success) {
-               setTestSetStatus(CreateFailed);
-               setTestSetSize(0, 0);
-               emit testSetCreateFailed("数据加密失败");
+           // 第二步：提交到工作线程加密，界面不阻塞
+           // 上一个测试集仍在加密时新任务排队执行，完成后只采用最新的测试集
+           m_encryptingInsideSize = insideSize;
+           m_encryptingOutsideSize = outsideSize;
+           m_encryptingTestSet = idCards;
+           m_encryptionService.submit(createId, idCards);
+       },
+       [this, createId](const QString& error) {
+           if (createId != m_createSeq) {
                return;
            }
-
-           qDebug() << "数据加密完成";
-           qDebug() << "Context大小:" << contextData.size();
-           qDebug() << "Payload大小:" << payloadData.size();
-
-           // 第三步：保存到本地内存（不再发送给后端）
-           m_cachedContextData = contextData;
-           m_cachedPayloadData = payloadData;
-
-           setTestSetStatus(Created);
-           setTestSetSize(m_pendingInsideSize, m_pendingOutsideSize);
-           setQueryStatus(NotExecuted);
-           setQueryResult(0, 0, 0.0);
-           emit testSetCreateSuccess();
-       },
-       [this](const QString& error) {
            setTestSetStatus(CreateFailed);
            setTestSetSize(0, 0);
            emit testSetCreateFailed("生成测试集失败: " + error);
@@ -180,9 +153,90 @@ void TestSetStore::createTestSet(int insideSize, int outsideSize)
        );
 }
 
+void TestSetStore::onEncryptProgress(int jobId, CryptoWrapper::EncryptStage stage, int done, int total)
+{
+    // 已被取代的任务仍在排队执行，其进度不再显示
+    if (jobId != m_createSeq) {
+        return;
+    }
+
+    QString stageText;
+    switch (stage) {
+    case CryptoWrapper::StageHashing:
+        stageText = "哈希";
+        break;
+    case CryptoWrapper::StageKeygen:
+        stageText = "密钥生成";
+        break;
+    case CryptoWrapper::StagePacking:
+        stageText = "加密打包";
+        break;
+    case CryptoWrapper::StageSerializing:
+        stageText = "序列化";
+        break;
+    }
+    int percent = total > 0 ? static_cast<int>(100LL * done / total) : 100;
+    emit testSetCreateProgress(stageText, percent);
+}
+
+void TestSetStore::onEncryptFinished(int jobId, bool success,
+                                     const QString& contextData, const QString& payloadData,
+                                     const RevealStatePtr& state)
+{
+    // 已有更新的创建请求，等待最新的测试集
+    if (jobId != m_createSeq) {
+        qDebug() << "加密任务" << jobId << "已过期，忽略结果";
+        return;
+    }
+
+    if (!success || !state) {
+        // 旧测试集已不再显示，负载与其解密状态一起作废
+        m_cachedPayloadData.clear();
+        m_cachedRevealState.reset();
+        setTestSetStatus(CreateFailed);
+        setTestSetSize(0, 0);
+        emit testSetCreateFailed("数据加密失败");
+        return;
+    }
+
+    qDebug() << "数据加密完成";
+    qDebug() << "Context大小:" << contextData.size();
+    qDebug() << "Payload大小:" << payloadData.size();
+
+    // 🔥 保存原始测试集
+    m_originalTestSet = m_encryptingTestSet;
+    m_pendingInsideSize = m_encryptingInsideSize;
+    m_pendingOutsideSize = m_encryptingOutsideSize;
+
+    // 🔥 保存库内身份证集合（最后一位是X的）
+    m_insideIdCards.clear();
+    for (const QString& idCard : m_originalTestSet) {
+        if (idCard.endsWith('X')) {
+            m_insideIdCards.insert(idCard);
+        }
+    }
+    qDebug() << "库内数量：" << m_insideIdCards.size();
+    qDebug() << "库外数量：" << (m_originalTestSet.size() - m_insideIdCards.size());
+
+    // 第三步：保存到本地内存（不再发送给后端）
+    // 上下文发生变化时需要重新向后端发送完整上下文
+    if (contextData != m_cachedContextData) {
+        m_contextAccepted = false;
+    }
+    m_cachedContextData = contextData;
+    m_cachedPayloadData = payloadData;
+    m_cachedRevealState = state;
+
+    setTestSetStatus(Created);
+    setTestSetSize(m_pendingInsideSize, m_pendingOutsideSize);
+    setQueryStatus(NotExecuted);
+    setQueryResult(0, 0, 0.0);
+    emit testSetCreateSuccess();
+}
+
 void TestSetStore::queryBlacklist()
 {
-    if (m_cachedContextData.isEmpty() || m_cachedPayloadData.isEmpty()) {
+    if (m_cachedContextData.isEmpty() || m_cachedPayloadData.isEmpty() || !m_cachedRevealState) {
         emit queryFailed("请先创建测试集");
         return;
     }
@@ -190,14 +244,31 @@ void TestSetStore::queryBlacklist()
     setQueryStatus(Querying);
     qDebug() << "开始查询，发送加密数据...";
 
-    // 记录开始时间
-    QDateTime startTime = QDateTime::currentDateTime();
+    // 记录开始时间，后端已缓存当前上下文时只发送摘要
+    sendQuery(m_cachedRevealState, m_cachedPayloadData, m_cachedContextData,
+              !m_contextAccepted, QDateTime::currentDateTime());
+}
+
+void TestSetStore::sendQuery(const RevealStatePtr& revealState, const QString& payloadData,
+                             const QString& contextData, bool withContext, const QDateTime& startTime)
+{
+    // 负载、上下文与解密状态在发送时一并捕获，结果只能用生成本次负载时的解密状态解密
+    const QString contextDigest = revealState->contextDigest;
+    const int totalCount = m_pendingInsideSize + m_pendingOutsideSize;
+    qDebug() << (withContext ? "发送完整上下文" : "仅发送上下文摘要") << contextDigest;
 
     // 调用API发送加密数据进行查询
     ApiService::instance().queryBlacklistWithData(
-        m_cachedPayloadData,
-        m_cachedContextData,
-        [this, startTime](const QJsonObject& response) {
+        payloadData,
+        withContext ? contextData : QString(),
+        contextDigest,
+        [this, startTime, revealState, totalCount](const QJsonObject& response) {
+            // 查询期间测试集已被替换，结果属于旧测试集，不修改任何状态直接丢弃
+            if (revealState != m_cachedRevealState) {
+                qDebug() << "测试集已替换，丢弃旧查询结果";
+                return;
+            }
+
             int code = response.value("code").toInt();
             if (code != 200) {
                 setQueryStatus(QueryFailed);
@@ -207,20 +278,32 @@ void TestSetStore::queryBlacklist()
             }
 
             // 解析加密结果
+            // 后端为分片模式时返回encryptedResults（每个psisrv分片一个），否则返回encryptedResult
             QJsonObject data = response.value("data").toObject();
-            QString encryptedResult = data.value("encryptedResult").toString();
-            if (encryptedResult.isEmpty()) {
+            QStringList encryptedResults;
+            const QJsonArray resultArray = data.value("encryptedResults").toArray();
+            for (const QJsonValue& value : resultArray) {
+                encryptedResults.append(value.toString());
+            }
+            if (encryptedResults.isEmpty()) {
+                QString encryptedResult = data.value("encryptedResult").toString();
+                if (!encryptedResult.isEmpty()) {
+                    encryptedResults.append(encryptedResult);
+                }
+            }
+            if (encryptedResults.isEmpty()) {
                 setQueryStatus(QueryFailed);
                 emit queryFailed("未收到查询结果");
                 return;
             }
 
-            qDebug() << "收到加密结果，大小:" << encryptedResult.size();
+            qDebug() << "收到加密结果，分片数:" << encryptedResults.size();
 
             // 解密结果，得到完整的匹配信息列表
             QVector<MatchedBlacklistInfo> matchedInfoList;
-            bool decryptSuccess = m_cryptoWrapper.decryptResultWithDetails(
-                encryptedResult,
+            bool decryptSuccess = CryptoWrapper::decryptResultsWithDetails(
+                *revealState,
+                encryptedResults,
                 matchedInfoList
                 );
 
@@ -257,7 +340,6 @@ void TestSetStore::queryBlacklist()
 
             // 统计匹配数量
             int matchCount = matchedInfoList.size();
-            int totalCount = m_pendingInsideSize + m_pendingOutsideSize;
 
             setQueryStatus(QueryCompleted);
             setQueryResult(matchCount, totalCount, elapsedTime);
@@ -265,9 +347,25 @@ void TestSetStore::queryBlacklist()
             // 可以将完整信息存储起来，供导出功能使用
             m_matchedInfoList = matchedInfoList;  // 需要在类中添加这个成员变量
 
+            // 后端已缓存本上下文，之后的查询只需发送摘要
+            m_contextAccepted = true;
+
             emit querySuccess();
         },
-        [this](const QString& error) {
+        [this, revealState, payloadData, contextData, withContext, startTime](const QString& error) {
+            // 测试集已被替换，失败也不再影响当前状态
+            if (revealState != m_cachedRevealState) {
+                qDebug() << "测试集已替换，忽略旧查询的错误";
+                return;
+            }
+
+            // 后端未缓存该上下文（重启或已淘汰），用发送时的负载补发完整上下文重试一次
+            if (!withContext && error.contains("code=409")) {
+                qDebug() << "后端未缓存上下文，重新发送完整上下文";
+                m_contextAccepted = false;
+                sendQuery(revealState, payloadData, contextData, true, startTime);
+                return;
+            }
             setQueryStatus(QueryFailed);
             emit queryFailed("查询失败: " + error);
         }
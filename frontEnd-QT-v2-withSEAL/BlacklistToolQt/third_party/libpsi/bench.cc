@@ -0,0 +1,385 @@
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include <optional>
+#include <print>
+#include <random>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+#include "./include/client.hpp"
+#include "./include/server.hpp"
+#include "include/context.hpp"
+
+using namespace psi;
+
+using key_type = size_t;
+using label_type = size_t;
+using labels_type = std::vector<label_type>;
+
+/**
+ * ------------------------------------------------------------
+ * psi_bench: per-phase timings for every libpsi protocol step
+ * ------------------------------------------------------------
+ * Sweeps (weight, effective_lambda, log_poly_mod) parameter sets,
+ * client set sizes and server database sizes, and writes one JSON
+ * record per (phase, parameter set, sizes) so results from two
+ * releases can be diffed directly.
+ *
+ * Options (all optional):
+ *   --params=15:16:14,15:16:13   weight:lambda:log_poly_mod list
+ *   --client=10,1000,100000      client set sizes
+ *   --server=1000,100000,1000000 server database sizes
+ *   --reps=3                     repetitions per measurement
+ *   --out=psi_bench.json         output file
+ */
+
+struct Params {
+    size_t weight;
+    size_t effective_lambda;
+    size_t log_poly_mod;
+};
+
+struct Record {
+    std::string phase;
+    Params params;
+    size_t client_size;
+    size_t server_size;
+    std::vector<double> samples_ms;
+    size_t bytes;
+    std::optional<size_t> matches;
+    std::string error;
+};
+
+struct Options {
+    std::vector<Params> params = {{15, 16, 14}, {15, 16, 13}, {10, 16, 14}};
+    std::vector<size_t> client_sizes = {10, 100, 1000, 10000, 100000};
+    std::vector<size_t> server_sizes = {1000, 100000, 1000000};
+    size_t reps = 3;
+    std::string out = "psi_bench.json";
+};
+
+/**
+ * Collects repeated timings of one phase.
+ *
+ * time() returns the callable's result by value, so it only fits movable
+ * results. client::Context and server::Context are not movable; time them
+ * with start()/stop() around the construction instead.
+ */
+class Phase {
+   public:
+    Phase(std::vector<Record>& records, std::string name, const Params& p,
+          size_t client_size, size_t server_size)
+        : records_(records), index_(records.size()) {
+        records.push_back(
+            Record{std::move(name), p, client_size, server_size, {}, 0, {}, {}}
+        );
+    }
+
+    template <typename F>
+    auto time(F&& f) -> decltype(f()) {
+        auto start = std::chrono::steady_clock::now();
+        if constexpr (std::is_void_v<decltype(f())>) {
+            f();
+            record(start);
+        } else {
+            auto ret = f();
+            record(start);
+            return ret;
+        }
+    }
+
+    auto start() const -> std::chrono::steady_clock::time_point {
+        return std::chrono::steady_clock::now();
+    }
+    void stop(std::chrono::steady_clock::time_point start) { record(start); }
+
+    void bytes(size_t n) { records_[index_].bytes = n; }
+    void matches(size_t n) { records_[index_].matches = n; }
+
+   private:
+    void record(std::chrono::steady_clock::time_point start) {
+        std::chrono::duration<double, std::milli> d =
+            std::chrono::steady_clock::now() - start;
+        records_[index_].samples_ms.push_back(d.count());
+    }
+
+    // records may grow while a phase is alive, so keep an index, not a reference
+    std::vector<Record>& records_;
+    size_t index_;
+};
+
+static auto split(std::string_view s, char sep) -> std::vector<std::string> {
+    std::vector<std::string> out;
+    size_t pos = 0;
+    while (pos <= s.size()) {
+        size_t next = s.find(sep, pos);
+        if (next == std::string_view::npos) {
+            next = s.size();
+        }
+        if (next > pos) {
+            out.emplace_back(s.substr(pos, next - pos));
+        }
+        pos = next + 1;
+    }
+    return out;
+}
+
+static auto parse_sizes(std::string_view s) -> std::vector<size_t> {
+    std::vector<size_t> out;
+    for (const auto& v : split(s, ',')) {
+        out.push_back(std::stoull(v));
+    }
+    return out;
+}
+
+static auto parse_params(std::string_view s) -> std::vector<Params> {
+    std::vector<Params> out;
+    for (const auto& item : split(s, ',')) {
+        auto f = split(item, ':');
+        if (f.size() != 3) {
+            throw std::invalid_argument("bad --params entry: " + item);
+        }
+        out.push_back({std::stoull(f[0]), std::stoull(f[1]), std::stoull(f[2])});
+    }
+    return out;
+}
+
+static auto parse_options(int argc, char** argv) -> Options {
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        auto eq = arg.find('=');
+        auto key = arg.substr(0, eq);
+        auto val = eq == std::string_view::npos ? std::string_view{} : arg.substr(eq + 1);
+        if (key == "--params") {
+            opt.params = parse_params(val);
+        } else if (key == "--client") {
+            opt.client_sizes = parse_sizes(val);
+        } else if (key == "--server") {
+            opt.server_sizes = parse_sizes(val);
+        } else if (key == "--reps") {
+            opt.reps = std::max<size_t>(1, std::stoull(std::string(val)));
+        } else if (key == "--out") {
+            opt.out = val;
+        } else {
+            throw std::invalid_argument("unknown option: " + std::string(arg));
+        }
+    }
+    return opt;
+}
+
+/**
+ * Server keys are random; the first half of the client set is drawn
+ * from the server keys so matching and reveal do real work.
+ */
+static auto make_server_data(size_t n, std::mt19937_64& rng)
+    -> std::map<key_type, labels_type> {
+    std::map<key_type, labels_type> kvs;
+    while (kvs.size() < n) {
+        kvs.emplace(rng(), labels_type{rng() & 0xffff});
+    }
+    return kvs;
+}
+
+static auto make_client_data(
+    size_t n, const std::map<key_type, labels_type>& kvs, std::mt19937_64& rng
+) -> std::set<key_type> {
+    std::set<key_type> set;
+    for (auto it = kvs.begin(); it != kvs.end() && set.size() < n / 2; ++it) {
+        set.insert(it->first);
+    }
+    while (set.size() < n) {
+        set.insert(rng());
+    }
+    return set;
+}
+
+static void bench_sizes(
+    std::vector<Record>& records, const Options& opt, const Params& p,
+    client::Context& cli_ctx, server::Context& srv_ctx, size_t cn, size_t sn
+) {
+    std::mt19937_64 rng(cn * 1000003 + sn);
+    auto kvs = make_server_data(sn, rng);
+    auto cli_data = make_client_data(cn, kvs, rng);
+
+    Phase pack(records, "pack_payload", p, cn, sn);
+    Phase cto(records, "CipherPayload::to_stream", p, cn, sn);
+    Phase cfrom(records, "CipherPayload::from_stream", p, cn, sn);
+    Phase spack(records, "pack_for_matching", p, cn, sn);
+    Phase match(records, "do_matching", p, cn, sn);
+    Phase rto(records, "ResultPayload::to_stream", p, cn, sn);
+    Phase rfrom(records, "ResultPayload::from_stream", p, cn, sn);
+    Phase reveal(records, "reveal_result", p, cn, sn);
+
+    for (size_t rep = 0; rep < opt.reps; ++rep) {
+        auto set = cli_data;
+        auto [payload, reveal_table] =
+            pack.time([&] { return client::pack_payload(cli_ctx, std::move(set)); });
+
+        auto buf = cto.time([&] { return payload.to_stream(); });
+        auto payload_bytes = buf.str();
+        cto.bytes(payload_bytes.size());
+
+        std::stringstream cstream(payload_bytes);
+        auto srv_recv =
+            cfrom.time([&] { return CipherPayload::from_stream(cstream, srv_ctx); });
+
+        auto kvs_copy = kvs;
+        auto labeled = spack.time([&] {
+            return server::pack_for_matching(srv_ctx, std::move(kvs_copy));
+        });
+
+        auto result = match.time([&] {
+            return server::do_matching(srv_ctx, std::move(srv_recv), std::move(labeled));
+        });
+
+        auto rbuf = rto.time([&] { return result.to_stream(); });
+        auto result_bytes = rbuf.str();
+        rto.bytes(result_bytes.size());
+
+        std::stringstream rstream(result_bytes);
+        auto cli_recv =
+            rfrom.time([&] { return ResultPayload::from_stream(rstream, cli_ctx); });
+
+        auto res = reveal.time([&] {
+            return client::reveal_result(cli_ctx, reveal_table, std::move(cli_recv));
+        });
+        reveal.matches(res.size());
+    }
+}
+
+static void bench_params(
+    std::vector<Record>& records, const Options& opt, const Params& p
+) {
+    std::println(
+        "params weight={} lambda={} log_poly_mod={}", p.weight,
+        p.effective_lambda, p.log_poly_mod
+    );
+
+    Phase create(records, "client::Context::create", p, 0, 0);
+    for (size_t rep = 0; rep + 1 < opt.reps; ++rep) {
+        auto start = create.start();
+        auto ctx = client::Context::create(p.weight, p.effective_lambda, p.log_poly_mod);
+        create.stop(start);
+    }
+    auto create_start = create.start();
+    auto cli_ctx = client::Context::create(p.weight, p.effective_lambda, p.log_poly_mod);
+    create.stop(create_start);
+
+    Phase to(records, "client::Context::to_stream", p, 0, 0);
+    Phase from(records, "server::Context::from_stream", p, 0, 0);
+    std::string ctx_bytes;
+    for (size_t rep = 0; rep < opt.reps; ++rep) {
+        ctx_bytes = to.time([&] { return cli_ctx.to_stream(); }).str();
+    }
+    to.bytes(ctx_bytes.size());
+
+    for (size_t rep = 1; rep < opt.reps; ++rep) {
+        std::stringstream in(ctx_bytes);
+        auto start = from.start();
+        auto ctx = server::Context::from_stream(in);
+        from.stop(start);
+    }
+    std::stringstream first(ctx_bytes);
+    auto from_start = from.start();
+    auto srv_ctx = server::Context::from_stream(first);
+    from.stop(from_start);
+
+    for (auto sn : opt.server_sizes) {
+        for (auto cn : opt.client_sizes) {
+            std::println("  client={} server={}", cn, sn);
+            // a failed run leaves its phase records half filled; drop them
+            // and keep only the error entry
+            size_t mark = records.size();
+            try {
+                bench_sizes(records, opt, p, cli_ctx, srv_ctx, cn, sn);
+            } catch (const std::exception& e) {
+                records.resize(mark);
+                records.push_back({"error", p, cn, sn, {}, 0, {}, e.what()});
+                std::println("    failed: {}", e.what());
+            }
+        }
+    }
+}
+
+static auto json_escape(std::string_view s) -> std::string {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += (static_cast<unsigned char>(c) < 0x20) ? ' ' : c;
+    }
+    return out;
+}
+
+static void write_json(const Options& opt, const std::vector<Record>& records) {
+    std::ofstream out(opt.out);
+    auto now = std::chrono::floor<std::chrono::seconds>(std::chrono::system_clock::now());
+    std::println(out, "{{");
+    std::println(out, "  \"timestamp\": \"{:%FT%TZ}\",", now);
+    std::println(out, "  \"reps\": {},", opt.reps);
+    std::println(out, "  \"results\": [");
+    for (size_t i = 0; i < records.size(); ++i) {
+        const auto& r = records[i];
+        double min = 0, mean = 0;
+        if (!r.samples_ms.empty()) {
+            min = *std::ranges::min_element(r.samples_ms);
+            mean = std::accumulate(r.samples_ms.begin(), r.samples_ms.end(), 0.0)
+                   / static_cast<double>(r.samples_ms.size());
+        }
+        std::print(
+            out,
+            "    {{\"phase\": \"{}\", \"weight\": {}, \"effective_lambda\": {}, "
+            "\"log_poly_mod\": {}, \"client_size\": {}, \"server_size\": {}, "
+            "\"samples\": {}, \"min_ms\": {:.3f}, \"mean_ms\": {:.3f}, \"bytes\": {}",
+            r.phase, r.params.weight, r.params.effective_lambda,
+            r.params.log_poly_mod, r.client_size, r.server_size,
+            r.samples_ms.size(), min, mean, r.bytes
+        );
+        if (r.matches) {
+            std::print(out, ", \"matches\": {}", *r.matches);
+        }
+        if (!r.error.empty()) {
+            std::print(out, ", \"error\": \"{}\"", json_escape(r.error));
+        }
+        std::println(out, "}}{}", i + 1 < records.size() ? "," : "");
+    }
+    std::println(out, "  ]");
+    std::println(out, "}}");
+}
+
+auto main(int argc, char** argv) -> int {
+    Options opt;
+    try {
+        opt = parse_options(argc, argv);
+    } catch (const std::exception& e) {
+        std::println(stderr, "{}", e.what());
+        return 1;
+    }
+
+    std::vector<Record> records;
+    for (const auto& p : opt.params) {
+        size_t mark = records.size();
+        try {
+            bench_params(records, opt, p);
+        } catch (const std::exception& e) {
+            records.resize(mark);
+            records.push_back({"error", p, 0, 0, {}, 0, {}, e.what()});
+            std::println("  failed: {}", e.what());
+        }
+    }
+
+    write_json(opt, records);
+    std::println("wrote {} records to {}", records.size(), opt.out);
+    return 0;
+}
@@ -350,6 +350,8 @@ void CreateTestSetWidget::setupConnections()
             this, &CreateTestSetWidget::onTestSetCreateSuccess);
     connect(&TestSetStore::instance(), &TestSetStore::testSetCreateFailed,
             this, &CreateTestSetWidget::onTestSetCreateFailed);
+    connect(&TestSetStore::instance(), &TestSetStore::testSetCreateProgress,
+            this, &CreateTestSetWidget::onTestSetCreateProgress);
     connect(&TestSetStore::instance(), &TestSetStore::querySuccess,
             this, &CreateTestSetWidget::onQuerySuccess);
     connect(&TestSetStore::instance(), &TestSetStore::queryFailed,
@@ -502,6 +504,14 @@ void CreateTestSetWidget::onTestSetCreateFailed(const QString& error)
     MessageHelper::showError(this, error.isEmpty() ? "测试集创建失败" : error);
 }
 
+void CreateTestSetWidget::onTestSetCreateProgress(const QString& stage, int percent)
+{
+    // 加密在工作线程进行，状态标签显示当前阶段
+    if (TestSetStore::instance().testSetStatus() == TestSetStore::Creating) {
+        m_statusTag->setText(QString("加密中：%1 %2%").arg(stage).arg(percent));
+    }
+}
+
 void CreateTestSetWidget::onQuerySuccess()
 {
     MessageHelper::showSuccess(this, "查询完成");